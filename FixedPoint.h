@@ -10,6 +10,27 @@
  * '-D_DEBUG_SHOW_OVERFLOW_INFO' for GCC or CLANG) which will display some
  * over-/underflow info during execution.
  *
+ * Similarly, compiling with '_DEBUG_COUNT_OPERATIONS' defined counts the
+ * additions, multiplications (per scenario), divisions, roundings and
+ * conversions performed for every combination of operand formats, and prints
+ * a summary at program exit. Useful for sizing hardware datapaths and for
+ * finding slow paths, e.g, scenario 2 multiplications in an inner loop.
+ *
+ * Compiling with '_DEBUG_PROFILE_RANGES' defined records the range and the
+ * rounding error of every result per format and per FixedPointRangeTag, and
+ * prints the smallest formats that avoid overflow and meet a precision target
+ * (see fixed_point_set_range_precision()) at program exit.
+ *
+ * Constants can be written as literals, e.g, 'FixedPoint<4,28> c = 1.5_fxp;',
+ * which are rounded at compile time and fail to compile if they do not fit.
+ *
+ * Scaling by integers and powers of two, e.g, 'x * 3', 'x >> n' and
+ * 'x.mul_pow2<-4>()', takes a single multiply or shift, and 'x / 10' needs no
+ * 128-bit division. The results are rounded like those of the FixedPoint
+ * operators. Constant coefficients, e.g, 'mul_const<1,15,9830>(x)', are
+ * multiplied by shifts and additions when they have at most
+ * '_FIXED_POINT_CSD_MAX_DIGITS' non-zero canonical signed digits.
+ *
  * CAVIATS:
  *
  *   * For rounding to work properly, the fractional part of the FixedPoint
@@ -36,6 +57,9 @@
 #include <string>
 #include <cmath>
 #include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
 
 /*
  * Test for compiler support of the __int128 integer data type. As of yet there
@@ -66,6 +90,660 @@
     }
 #endif
 
+/*
+ * Operation counting stuff for estimating hardware cost.
+ */
+#ifdef _DEBUG_COUNT_OPERATIONS
+    #include <iostream>
+    #include <map>
+    #include <mutex>
+    #include <tuple>
+    #include <vector>
+
+    namespace fixed_point_detail
+    {
+        /*
+         * Counted operations. Binary operations are counted per pair of
+         * operand formats, all other operations per format.
+         */
+        enum class CountedOp
+        {
+            add, sub, neg, mul_scenario1, mul_scenario2, mul_const, div,
+            round, from_fixed_point, from_double, from_int, to_double
+        };
+
+        inline const char *counted_op_name(CountedOp op) noexcept
+        {
+            switch (op)
+            {
+                case CountedOp::add:              return "add";
+                case CountedOp::sub:              return "sub";
+                case CountedOp::neg:              return "neg";
+                case CountedOp::mul_scenario1:    return "mul_scenario1";
+                case CountedOp::mul_scenario2:    return "mul_scenario2";
+                case CountedOp::mul_const:        return "mul_const";
+                case CountedOp::div:              return "div";
+                case CountedOp::round:            return "round";
+                case CountedOp::from_fixed_point: return "from_fixed_point";
+                case CountedOp::from_double:      return "from_double";
+                case CountedOp::from_int:         return "from_int";
+                case CountedOp::to_double:        return "to_double";
+            }
+            return "";
+        }
+
+        /*
+         * Counter key, an operation and the formats of its operands. The
+         * right hand side format is <0,0> for operations with one operand.
+         */
+        struct CountedOpKey
+        {
+            CountedOp op;
+            int lhs_int_bits, lhs_frac_bits;
+            int rhs_int_bits, rhs_frac_bits;
+        };
+
+        /*
+         * Process wide operation counts. Every counter key gets a small
+         * integer id on first use, and threads count into thread local arrays
+         * indexed by that id, which are merged here when a thread exits. The
+         * summary is printed to std::cerr at program exit.
+         */
+        class OpCounts
+        {
+        public:
+            OpCounts() = default;
+            OpCounts(const OpCounts &) = delete;
+            OpCounts &operator=(const OpCounts &) = delete;
+            ~OpCounts() { this->report(std::cerr); }
+
+            std::size_t register_key(const CountedOpKey &key)
+            {
+                std::lock_guard<std::mutex> lock{ this->mutex };
+                this->keys.push_back(key);
+                this->totals.push_back(0);
+                return this->keys.size() - 1;
+            }
+
+            void merge(std::vector<unsigned long long> &counts)
+            {
+                std::lock_guard<std::mutex> lock{ this->mutex };
+                for (std::size_t id=0; id<counts.size(); ++id)
+                    this->totals[id] += counts[id];
+                std::fill(counts.begin(), counts.end(), 0);
+            }
+
+            void report(std::ostream &os)
+            {
+                std::lock_guard<std::mutex> lock{ this->mutex };
+
+                // Sort by operation and formats, skip unused keys.
+                std::map<std::tuple<int,int,int,int,int>, std::size_t> order{};
+                for (std::size_t id=0; id<this->keys.size(); ++id)
+                {
+                    const CountedOpKey &k = this->keys[id];
+                    if (this->totals[id])
+                        order[std::make_tuple(static_cast<int>(k.op),
+                                    k.lhs_int_bits, k.lhs_frac_bits,
+                                    k.rhs_int_bits, k.rhs_frac_bits)] = id;
+                }
+                if (order.empty())
+                    return;
+
+                os << "PoorMansFixedPoint operation counts:\n";
+                for (const auto &entry : order)
+                {
+                    const CountedOpKey &k = this->keys[entry.second];
+                    std::string formats = "<" + std::to_string(k.lhs_int_bits)
+                        + "," + std::to_string(k.lhs_frac_bits) + ">";
+                    if (k.rhs_int_bits || k.rhs_frac_bits)
+                        formats += ", <" + std::to_string(k.rhs_int_bits)
+                            + "," + std::to_string(k.rhs_frac_bits) + ">";
+                    std::string name = counted_op_name(k.op);
+                    name.resize(std::max<std::size_t>(name.size(), 18), ' ');
+                    formats.resize(std::max<std::size_t>(formats.size(), 18),
+                                   ' ');
+                    os << "    " << name << formats << " "
+                       << this->totals[entry.second] << "\n";
+                }
+                os.flush();
+            }
+
+        private:
+            std::mutex mutex{};
+            std::vector<CountedOpKey> keys{};
+            std::vector<unsigned long long> totals{};
+        };
+
+        inline OpCounts &op_counts()
+        {
+            static OpCounts counts{};
+            return counts;
+        }
+
+        /*
+         * Thread local counters, merged into the process wide counts when the
+         * thread exits.
+         */
+        class ThreadOpCounts
+        {
+        public:
+            ThreadOpCounts() { op_counts(); }
+            ThreadOpCounts(const ThreadOpCounts &) = delete;
+            ThreadOpCounts &operator=(const ThreadOpCounts &) = delete;
+            ~ThreadOpCounts() { op_counts().merge(this->counts); }
+
+            void increment(std::size_t id)
+            {
+                if (id >= this->counts.size())
+                    this->counts.resize(id+1, 0);
+                ++this->counts[id];
+            }
+
+            void flush() { op_counts().merge(this->counts); }
+
+        private:
+            std::vector<unsigned long long> counts{};
+        };
+
+        inline ThreadOpCounts &thread_op_counts()
+        {
+            static thread_local ThreadOpCounts counts{};
+            return counts;
+        }
+
+        template <CountedOp OP, int LHS_INT_BITS, int LHS_FRAC_BITS,
+                  int RHS_INT_BITS, int RHS_FRAC_BITS>
+        void count_op()
+        {
+            static const std::size_t id = op_counts().register_key(
+                    { OP, LHS_INT_BITS, LHS_FRAC_BITS,
+                          RHS_INT_BITS, RHS_FRAC_BITS });
+            thread_op_counts().increment(id);
+        }
+    }
+
+    /*
+     * Print the operation counts so far, including the counts of the calling
+     * thread, but not those of other still running threads.
+     */
+    inline void fixed_point_report_op_counts(std::ostream &os)
+    {
+        fixed_point_detail::thread_op_counts().flush();
+        fixed_point_detail::op_counts().report(os);
+    }
+
+    #define _FIXED_POINT_COUNT_OP(OP, LHS_INT, LHS_FRAC, RHS_INT, RHS_FRAC)  \
+        fixed_point_detail::count_op<fixed_point_detail::CountedOp::OP,      \
+                                     LHS_INT, LHS_FRAC, RHS_INT, RHS_FRAC>()
+#else
+    #define _FIXED_POINT_COUNT_OP(OP, LHS_INT, LHS_FRAC, RHS_INT, RHS_FRAC)  \
+        static_cast<void>(0)
+#endif
+
+/*
+ * Dynamic range profiling stuff for choosing FixedPoint formats.
+ */
+#ifdef _DEBUG_PROFILE_RANGES
+    #include <iostream>
+    #include <map>
+    #include <mutex>
+    #include <string>
+    #include <tuple>
+
+    namespace fixed_point_detail
+    {
+        /*
+         * Statistics of the Q(32,32) results seen by round(), rounded to the
+         * fractional bits of the format but before wrap around, and of the
+         * error of that rounding.
+         */
+        struct RangeStats
+        {
+            unsigned long long count{};
+            unsigned long long overflows{};
+            long long min{};
+            long long max{};
+            unsigned long long frac_bits_used{};
+            long long max_abs_error{};
+            double sum_sq_error{};
+
+            void record(long long num, int int_bits, int frac_bits) noexcept
+            {
+                // Round to the nearest number with frac_bits bits, like
+                // round(). Numbers with 32 fractional bits are not rounded.
+                long long rounded = num;
+                if (frac_bits < 32)
+                {
+                    int shift = 32 - frac_bits;
+                    rounded = static_cast<long long>(
+                            static_cast<unsigned long long>(
+                                ((num >> (shift-1)) + 1) >> 1) << shift);
+                }
+                long long error = rounded - num;
+                long long abs_error = error < 0 ? -error : error;
+                this->max_abs_error = std::max(this->max_abs_error, abs_error);
+                this->sum_sq_error += static_cast<double>(error) *
+                                      static_cast<double>(error);
+
+                if (this->count == 0 || rounded < this->min)
+                    this->min = rounded;
+                if (this->count == 0 || rounded > this->max)
+                    this->max = rounded;
+                ++this->count;
+                this->frac_bits_used |= static_cast<unsigned long long>(
+                        rounded);
+
+                // Values outside of the int_bits integer range.
+                long long msb_extended = rounded >> (31+int_bits);
+                if (msb_extended != -1ll && msb_extended != 0ll)
+                    ++this->overflows;
+            }
+
+            void merge(const RangeStats &rhs) noexcept
+            {
+                if (rhs.count == 0)
+                    return;
+                if (this->count == 0 || rhs.min < this->min)
+                    this->min = rhs.min;
+                if (this->count == 0 || rhs.max > this->max)
+                    this->max = rhs.max;
+                this->count += rhs.count;
+                this->overflows += rhs.overflows;
+                this->frac_bits_used |= rhs.frac_bits_used;
+                this->max_abs_error = std::max(this->max_abs_error,
+                                               rhs.max_abs_error);
+                this->sum_sq_error += rhs.sum_sq_error;
+            }
+
+            /*
+             * Smallest number of integer bits that fits every recorded value.
+             */
+            int suggested_int_bits() const noexcept
+            {
+                auto width = [](long long x)
+                {
+                    unsigned long long m =
+                        static_cast<unsigned long long>(x ^ (x >> 63));
+                    int bits = 1;
+                    while (m) { m >>= 1; ++bits; }
+                    return bits;
+                };
+                return std::max(width(this->min), width(this->max)) - 32;
+            }
+
+            /*
+             * Smallest number of fractional bits with a rounding error of at
+             * most 'max_abs_error', or that represents every recorded value
+             * exactly if that takes fewer bits. A zero 'max_abs_error' asks
+             * for exact representation of the rounded values, i.e, at most
+             * the fractional bits of the recorded format.
+             */
+            int suggested_frac_bits(double max_abs_error) const noexcept
+            {
+                int exact = 0;
+                unsigned long long frac = this->frac_bits_used & 0xFFFFFFFFull;
+                while (frac & ((1ull << (32-exact)) - 1))
+                    ++exact;
+                if (max_abs_error <= 0.0)
+                    return exact;
+                int target = static_cast<int>(
+                        std::ceil(-std::log2(max_abs_error))) - 1;
+                return std::min(exact, std::max(target, -31));
+            }
+        };
+
+        /*
+         * Process wide range statistics per tag and format. Threads record
+         * into thread local tables which are merged here when a thread exits.
+         * The report is printed to std::cerr at program exit.
+         */
+        class RangeProfile
+        {
+        public:
+            using key_type = std::tuple<std::string, int, int>;
+
+            RangeProfile() = default;
+            RangeProfile(const RangeProfile &) = delete;
+            RangeProfile &operator=(const RangeProfile &) = delete;
+            ~RangeProfile() { this->report(std::cerr); }
+
+            void merge(const key_type &key, const RangeStats &stats)
+            {
+                std::lock_guard<std::mutex> lock{ this->mutex };
+                this->stats[key].merge(stats);
+            }
+
+            void set_precision(double max_abs_error)
+            {
+                std::lock_guard<std::mutex> lock{ this->mutex };
+                this->precision = max_abs_error;
+            }
+
+            void report(std::ostream &os)
+            {
+                std::lock_guard<std::mutex> lock{ this->mutex };
+                if (this->stats.empty())
+                    return;
+
+                const double scale = 1.0 / static_cast<double>(1ll << 32);
+                os << "PoorMansFixedPoint dynamic ranges:\n";
+                for (const auto &entry : this->stats)
+                {
+                    const std::string &tag = std::get<0>(entry.first);
+                    const RangeStats &s = entry.second;
+                    double rms = std::sqrt(
+                            s.sum_sq_error / static_cast<double>(s.count));
+                    os << "    " << (tag.empty() ? "(untagged)" : tag)
+                       << " <" << std::get<1>(entry.first) << ","
+                       << std::get<2>(entry.first) << ">: "
+                       << s.count << " values in ["
+                       << static_cast<double>(s.min) * scale << ", "
+                       << static_cast<double>(s.max) * scale << "], "
+                       << "max error "
+                       << static_cast<double>(s.max_abs_error) * scale << ", "
+                       << "rms error " << rms * scale << ", "
+                       << s.overflows << " overflows, ";
+
+                    // Any format represents zero, so there is nothing to
+                    // suggest from zero-only data.
+                    if (s.min == 0 && s.max == 0)
+                    {
+                        os << "no suggestion\n";
+                        continue;
+                    }
+                    int int_bits = s.suggested_int_bits();
+                    int frac_bits = s.suggested_frac_bits(this->precision);
+                    if (int_bits + frac_bits <= 0)
+                        frac_bits = 1 - int_bits;
+                    os << "suggest <" << int_bits << "," << frac_bits << ">\n";
+                }
+                os.flush();
+            }
+
+        private:
+            std::mutex mutex{};
+            std::map<key_type, RangeStats> stats{};
+            double precision{};
+        };
+
+        inline RangeProfile &range_profile()
+        {
+            static RangeProfile profile{};
+            return profile;
+        }
+
+        /*
+         * Thread local statistics, keyed by tag pointer and format, merged
+         * into the process wide statistics when the thread exits.
+         */
+        class ThreadRangeProfile
+        {
+        public:
+            ThreadRangeProfile() { range_profile(); }
+            ThreadRangeProfile(const ThreadRangeProfile &) = delete;
+            ThreadRangeProfile &operator=(const ThreadRangeProfile &) = delete;
+            ~ThreadRangeProfile() { this->flush(); }
+
+            void record(long long num, int int_bits, int frac_bits)
+            {
+                auto key = std::make_tuple(this->tag, int_bits, frac_bits);
+                this->stats[key].record(num, int_bits, frac_bits);
+            }
+
+            void flush()
+            {
+                for (const auto &entry : this->stats)
+                {
+                    const char *tag = std::get<0>(entry.first);
+                    range_profile().merge(
+                            std::make_tuple(std::string{ tag ? tag : "" },
+                                            std::get<1>(entry.first),
+                                            std::get<2>(entry.first)),
+                            entry.second);
+                }
+                this->stats.clear();
+            }
+
+            const char *tag{ nullptr };
+
+        private:
+            std::map<std::tuple<const char *, int, int>, RangeStats> stats{};
+        };
+
+        inline ThreadRangeProfile &thread_range_profile()
+        {
+            static thread_local ThreadRangeProfile profile{};
+            return profile;
+        }
+    }
+
+    /*
+     * Set the precision target of the suggested formats, as the largest
+     * acceptable absolute rounding error. Zero, the default, suggests formats
+     * that represent every recorded value exactly, after it is rounded to
+     * its own format.
+     */
+    inline void fixed_point_set_range_precision(double max_abs_error)
+    {
+        fixed_point_detail::range_profile().set_precision(max_abs_error);
+    }
+
+    /*
+     * Print the dynamic ranges so far, including those of the calling thread,
+     * but not those of other still running threads.
+     */
+    inline void fixed_point_report_ranges(std::ostream &os)
+    {
+        fixed_point_detail::thread_range_profile().flush();
+        fixed_point_detail::range_profile().report(os);
+    }
+
+    #define _FIXED_POINT_RECORD_RANGE(INT, FRAC, NUM)                        \
+        fixed_point_detail::thread_range_profile().record(NUM, INT, FRAC)
+#else
+    #define _FIXED_POINT_RECORD_RANGE(INT, FRAC, NUM)                        \
+        static_cast<void>(0)
+#endif
+
+/*
+ * Scoped tag for the dynamic range profiling. Results of all FixedPoint
+ * operations of the current thread are recorded under the innermost tag in
+ * scope. The tag string must outlive the FixedPointRangeTag object. Does
+ * nothing unless '_DEBUG_PROFILE_RANGES' is defined.
+ *
+ *     {
+ *         FixedPointRangeTag tag{ "fir_accumulator" };
+ *         acc += x[i] * h[i];
+ *     }
+ */
+class FixedPointRangeTag
+{
+public:
+#ifdef _DEBUG_PROFILE_RANGES
+    explicit FixedPointRangeTag(const char *tag)
+        : previous{ fixed_point_detail::thread_range_profile().tag }
+    {
+        fixed_point_detail::thread_range_profile().tag = tag;
+    }
+    ~FixedPointRangeTag()
+    {
+        fixed_point_detail::thread_range_profile().tag = this->previous;
+    }
+
+private:
+    const char *previous;
+#else
+    explicit FixedPointRangeTag(const char *) noexcept {}
+#endif
+
+public:
+    FixedPointRangeTag(const FixedPointRangeTag &) = delete;
+    FixedPointRangeTag &operator=(const FixedPointRangeTag &) = delete;
+};
+
+
+namespace fixed_point_detail
+{
+    /*
+     * Arithmetic right shift of 'x' by N bits, or left shift by -N bits if N
+     * is negative, e.g, for FixedPoint numbers with negative INT_BITS.
+     */
+    template <int N>
+    constexpr long long shift_right(long long x) noexcept
+    {
+        using uns_ll = unsigned long long;
+        return N >= 0 ? x >> (N >= 0 ? N : 0) : static_cast<long long>(
+                static_cast<uns_ll>(x) << (N < 0 ? -N : 0));
+    }
+
+    /*
+     * Enables the FixedPoint operators with integer operands for integer
+     * types only, such that 'x * 1.5' does not silently become 'x * 1'.
+     */
+    template <typename T>
+    using if_integer =
+        typename std::enable_if<std::is_integral<T>::value, int>::type;
+
+    __extension__ typedef __int128 literal_int;
+
+    /*
+     * Decimal literal mantissa*10^exponent, parsed at compile time. Digits
+     * beyond the 18th significant digit are ignored.
+     */
+    struct decimal_literal
+    {
+        long long mantissa;
+        int exponent;
+        bool valid;
+    };
+
+    constexpr decimal_literal parse_decimal(const char *s) noexcept
+    {
+        decimal_literal res{ 0, 0, true };
+        bool fraction = false;
+        for (; *s && *s != 'e' && *s != 'E'; ++s)
+        {
+            if (*s == '\'')
+                continue;
+            if (*s == '.')
+            {
+                fraction = true;
+                continue;
+            }
+            if (*s < '0' || *s > '9')
+                res.valid = false;
+            else if (res.mantissa >= 100000000000000000ll)
+                res.exponent += fraction ? 0 : 1;
+            else
+            {
+                res.mantissa = 10*res.mantissa + (*s - '0');
+                res.exponent -= fraction ? 1 : 0;
+            }
+        }
+        if (*s)
+        {
+            bool negative = *++s == '-';
+            if (*s == '-' || *s == '+')
+                ++s;
+            int exponent = 0;
+            for (; *s; ++s)
+            {
+                if (*s < '0' || *s > '9')
+                    res.valid = false;
+                else if (exponent < 1000)
+                    exponent = 10*exponent + (*s - '0');
+            }
+            res.exponent += negative ? -exponent : exponent;
+        }
+        return res;
+    }
+    template <char... CHARS>
+    constexpr decimal_literal parse_literal() noexcept
+    {
+        const char str[] = { CHARS..., '\0' };
+        return parse_decimal(str);
+    }
+
+    /*
+     * Raw integer of literal mantissa*10^exponent with frac_bits >= 0
+     * fractional bits, rounded to nearest with ties upwards. Literals too
+     * large for any FixedPoint number result in 2^100.
+     */
+    constexpr literal_int literal_raw(long long mantissa, int exponent,
+                                      int frac_bits) noexcept
+    {
+        if (mantissa == 0 || exponent < -36)
+            return 0;
+        literal_int num{ mantissa }, den{ 1 };
+        for (; exponent > 0; --exponent)
+        {
+            if (num > (literal_int{ 1 } << 80) ||
+                num < -(literal_int{ 1 } << 80))
+            {
+                return literal_int{ 1 } << 100;
+            }
+            num *= 10;
+        }
+        for (; exponent < 0; ++exponent)
+            den *= 10;
+
+        // floor((num*2^frac_bits + den/2) / den).
+        num = 2 * num * (literal_int{ 1 } << frac_bits) + den;
+        den *= 2;
+        literal_int quotient{ num / den };
+        return (num % den != 0 && num < 0) ? quotient - 1 : quotient;
+    }
+
+    /*
+     * Test if a raw integer fits in 'bits' bits.
+     */
+    constexpr bool literal_fits(literal_int raw, int bits) noexcept
+    {
+        return raw >= -(literal_int{ 1 } << (bits-1)) &&
+               raw <   (literal_int{ 1 } << (bits-1));
+    }
+}
+
+
+/*
+ * Decimal literal of a FixedPoint number, e.g, 1.5_fxp or -2.5e-3_fxp. The
+ * literal is kept exact, as mantissa*10^exponent, until it initializes a
+ * FixedPoint number, where it is rounded at compile time:
+ *
+ *     FixedPoint<4,28> c = 1.5_fxp;
+ *     acc += FixedPoint<4,32>{ 4.0_fxp } / divisor;
+ */
+template <long long MANTISSA, int EXPONENT>
+struct FixedPointLiteral
+{
+    constexpr FixedPointLiteral<-MANTISSA, EXPONENT> operator-() const noexcept
+    {
+        return {};
+    }
+    constexpr FixedPointLiteral operator+() const noexcept
+    {
+        return *this;
+    }
+};
+
+template <char... CHARS>
+constexpr FixedPointLiteral<
+        fixed_point_detail::parse_literal<CHARS...>().mantissa,
+        fixed_point_detail::parse_literal<CHARS...>().exponent>
+    operator"" _fxp() noexcept
+{
+    static_assert(fixed_point_detail::parse_literal<CHARS...>().valid,
+            "PoorMansFixedPoint: only decimal literals are supported.");
+    return {};
+}
+
+
+namespace fixed_point_detail
+{
+    struct const_multiplier;
+}
+
 
 /*
  * Type FixedPoint begin.
@@ -97,7 +775,10 @@ protected:
     /*
      * Long long is guaranteed to be atleast 64-bits wide. We use the 32 most
      * significant bits to store the integer part and the 32 least significant
-     * bits to store the fraction.
+     * bits to store the fraction. The number is always kept sign extended from
+     * bit 31+INT_BITS, and with the bits below the FRAC_BITS fractional bits
+     * cleared, so that numbers of any format can be added and compared without
+     * first being sign extended.
      */
     long long num{};
 
@@ -107,6 +788,7 @@ protected:
      */
     template <int _INT_BITS, int _FRAC_BITS>
     friend class FixedPoint;
+    friend struct fixed_point_detail::const_multiplier;
 
     /*
      * Private rounding method. This method will round the result of some
@@ -115,6 +797,9 @@ protected:
      */
     void round() noexcept
     {
+        _FIXED_POINT_COUNT_OP(round, INT_BITS, FRAC_BITS, 0, 0);
+        _FIXED_POINT_RECORD_RANGE(INT_BITS, FRAC_BITS, this->num);
+
         /*
          * Perform rounding by adding 2^(-FRAC_BITS)/2.
          */
@@ -135,41 +820,113 @@ protected:
             ss << "'of value: " << (this->num >> 32) << " + ";
             ss << this->get_frac_quotient() << ", ";
 
-            // Apply bitmask and print truncated result.
-            if (INT_BITS+FRAC_BITS < 64)
-                this->num &= ((1ull<<(INT_BITS+FRAC_BITS))-1) << (32-FRAC_BITS);
-            ss << "truncated to: " << (this->get_num_sign_extended() >> 32);
+            // Wrap around and print truncated result.
+            this->truncate();
+            ss << "truncated to: " << (this->num >> 32);
             ss << " + " << this->get_frac_quotient();
             _DEBUG_PRINT_FUNC(ss.str().c_str());
         }
         else
         {
-            if (INT_BITS+FRAC_BITS < 64)
-                this->num &= ((1ull<<(INT_BITS+FRAC_BITS))-1) << (32-FRAC_BITS);
+            this->truncate();
         }
     #else
         /*
-         * Debugmode disabled. Just apply the bitmask.
+         * Debugmode disabled. Just truncate the result.
          */
-        if (INT_BITS+FRAC_BITS < 64)
-            this->num &= ((1ull<<(INT_BITS+FRAC_BITS))-1) << (32-FRAC_BITS);
+        this->truncate();
     #endif
     }
 
     /*
-     * Get the current number sign extended to Q(32, 32) format.
+     * Discard the fractional bits beyond FRAC_BITS and wrap the number around
+     * to INT_BITS integer bits, leaving it sign extended to Q(32,32) format.
+     */
+    void truncate() noexcept
+    {
+        this->wrap();
+        if (FRAC_BITS < 32)
+            this->num &= static_cast<long long>(~0ull << (32-FRAC_BITS));
+    }
+
+    /*
+     * Wrap the number around to INT_BITS integer bits. Instead of testing
+     * for overflow, we left shift the sign bit of the format (unsigned,
+     * logically) all the way to the MSb, and then shift it (signed,
+     * arithmetically) back to its original position.
+     */
+    void wrap() noexcept
+    {
+        using uns_ll = unsigned long long;
+        uns_ll l = static_cast<uns_ll>(this->num) << (32-INT_BITS);
+        this->num = static_cast<long long>(l) >> (32-INT_BITS);
+    }
+
+    /*
+     * Round a result which is known, at compile time, to fit in SRC_INT_BITS
+     * integer bits and SRC_FRAC_BITS fractional bits. The rounding is elided
+     * if the result has no more fractional bits than FRAC_BITS, and the wrap
+     * around too if it has no more integer bits than INT_BITS, e.g, for
+     * widening conversions.
+     */
+    template <int SRC_INT_BITS, int SRC_FRAC_BITS>
+    void round_from() noexcept
+    {
+    #ifdef _DEBUG_SHOW_OVERFLOW_INFO
+        this->round();
+    #else
+        if (SRC_FRAC_BITS > FRAC_BITS)
+        {
+            this->round();
+        }
+        else
+        {
+            _FIXED_POINT_RECORD_RANGE(INT_BITS, FRAC_BITS, this->num);
+            if (SRC_INT_BITS > INT_BITS)
+                this->wrap();
+        }
+    #endif
+    }
+
+    /*
+     * Get the current number sign extended to Q(32, 32) format. This is how
+     * the number is stored, so it is free.
      */
     long long get_num_sign_extended() const noexcept
     {
-        /*
-         * Instead of of testing whether we need to sign extend the internal
-         * number num, we left shift it (unsigned, logically) all the way to the
-         * MSb, and then shift it (signed, arithmeticaly) back to its original
-         * position. This seem to have performance benifits.
-         */
+        return this->num;
+    }
+
+    /*
+     * The number times an integer, modulo 2^64, in Q(32,32) format.
+     */
+    template <typename INT>
+    long long mul_int(INT rhs) const noexcept
+    {
         using uns_ll = unsigned long long;
-        uns_ll l = static_cast<uns_ll>(num) << (32-INT_BITS);
-        return static_cast<long long>(l) >> (32-INT_BITS);
+        return static_cast<long long>(static_cast<uns_ll>(this->num) *
+                                      static_cast<uns_ll>(rhs));
+    }
+
+    /*
+     * The number divided by an integer, rounded towards -INF to Q(32,32)
+     * format. Just as for FixedPoint division, the result of dividing
+     * Q(32,32) -2^31 by -1 wraps around.
+     */
+    template <typename INT>
+    long long div_int(INT rhs) const noexcept
+    {
+        long long dividend{ this->num };
+        long long divisor{ static_cast<long long>(rhs) };
+        if (INT_BITS >= 32 && divisor == -1)
+        {
+            using uns_ll = unsigned long long;
+            return static_cast<long long>(-static_cast<uns_ll>(dividend));
+        }
+        long long quotient{ dividend/divisor };
+        if ((dividend < 0) != (divisor < 0) && quotient*divisor != dividend)
+            --quotient;
+        return quotient;
     }
 
     /*
@@ -192,8 +949,10 @@ public:
     template <int RHS_INT_BITS, int RHS_FRAC_BITS>
     FixedPoint(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs) noexcept
     {
+        _FIXED_POINT_COUNT_OP(from_fixed_point,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
         this->num = rhs.get_num_sign_extended();
-        this->round();
+        this->round_from<RHS_INT_BITS, RHS_FRAC_BITS>();
     }
     FixedPoint(const FixedPoint<INT_BITS, FRAC_BITS> &rhs) noexcept
     {
@@ -209,6 +968,7 @@ public:
      */
     explicit FixedPoint(double a)
     {
+        _FIXED_POINT_COUNT_OP(from_double, INT_BITS, FRAC_BITS, 0, 0);
         this->num = std::llround(a * static_cast<double>(1ll << 32));
         this->round();
     }
@@ -218,8 +978,30 @@ public:
      */
     explicit FixedPoint(int n) noexcept
     {
+        _FIXED_POINT_COUNT_OP(from_int, INT_BITS, FRAC_BITS, 0, 0);
         this->num = static_cast<long long>(n) << 32;
-        this->round();
+        this->round_from<32, 0>();
+    }
+
+    /*
+     * Constructor from literals, e.g, 1.5_fxp. The literal is rounded to
+     * nearest, with ties upwards, at compile time, so this is a plain store.
+     * A literal which does not fit in the format is a compile error.
+     */
+    template <long long MANTISSA, int EXPONENT>
+    FixedPoint(FixedPointLiteral<MANTISSA, EXPONENT>) noexcept
+    {
+        static_assert(FRAC_BITS >= 0,
+                "Literals need a non-negative number of fractional bits.");
+        constexpr fixed_point_detail::literal_int RAW{
+            fixed_point_detail::literal_raw(MANTISSA, EXPONENT, FRAC_BITS) };
+        static_assert(fixed_point_detail::literal_fits(
+                          RAW, INT_BITS+FRAC_BITS),
+                "Literal does not fit in the FixedPoint format.");
+        using uns_ll = unsigned long long;
+        constexpr long long NUM{ static_cast<long long>(
+                static_cast<uns_ll>(RAW) << (32-FRAC_BITS)) };
+        this->num = NUM;
     }
 
     /*
@@ -239,6 +1021,28 @@ public:
     constexpr int get_int_bits() const noexcept { return INT_BITS; }
     constexpr int get_frac_bits() const noexcept { return FRAC_BITS; }
 
+    /*
+     * Retrieve the underlying integer of the FixedPoint number, that is, the
+     * number scaled by 2^FRAC_BITS and sign extended to a long long. Useful
+     * for fast printouts and serialization of FixedPoint numbers.
+     */
+    long long get_raw() const noexcept
+    {
+        return this->get_num_sign_extended() >> (32-FRAC_BITS);
+    }
+
+    /*
+     * Set the underlying integer of the FixedPoint number. Bits that do not fit
+     * into INT_BITS+FRAC_BITS bits are truncated.
+     */
+    void set_raw(long long raw) noexcept
+    {
+        using uns_ll = unsigned long long;
+        this->num = static_cast<long long>(
+                static_cast<uns_ll>(raw) << (32-FRAC_BITS));
+        this->round_from<32, FRAC_BITS>();
+    }
+
     /*
      * Retrieve a string of the fractional part of the FixedPoint number, useful
      * for displaying the FixedPoint number content. The string will be on the
@@ -269,8 +1073,10 @@ public:
     FixedPoint<INT_BITS, FRAC_BITS> &
         operator=(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs) noexcept
     {
+        _FIXED_POINT_COUNT_OP(from_fixed_point,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
         this->num = rhs.get_num_sign_extended();
-        this->round();
+        this->round_from<RHS_INT_BITS, RHS_FRAC_BITS>();
         return *this;
     }
     FixedPoint<INT_BITS, FRAC_BITS> &
@@ -285,6 +1091,8 @@ public:
      */
     explicit operator double() const noexcept
     {
+        _FIXED_POINT_COUNT_OP(to_double, INT_BITS, FRAC_BITS, 0, 0);
+
         // Test if sign extension is needed.
         return static_cast<double>(this->get_num_sign_extended()) /
                static_cast<double>(1ll << 32);
@@ -295,9 +1103,10 @@ public:
      */
     FixedPoint<INT_BITS, FRAC_BITS> operator-() const noexcept
     {
+        _FIXED_POINT_COUNT_OP(neg, INT_BITS, FRAC_BITS, 0, 0);
         FixedPoint<INT_BITS, FRAC_BITS> res{};
         res.num = -( this->get_num_sign_extended() );
-        res.round();
+        res.round_from<INT_BITS+1, FRAC_BITS>();
         return res;
     }
 
@@ -310,17 +1119,23 @@ public:
         operator+(const FixedPoint<RHS_INT_BITS,RHS_FRAC_BITS> &rhs)
         const noexcept
     {
+        _FIXED_POINT_COUNT_OP(add,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
         FixedPoint<INT_BITS, FRAC_BITS> res;
         res.num = this->get_num_sign_extended() + rhs.get_num_sign_extended();
-        res.round();
+        res.round_from<std::max(INT_BITS, RHS_INT_BITS)+1,
+                      std::max(FRAC_BITS, RHS_FRAC_BITS)>();
         return res;
     }
     template <int RHS_INT_BITS, int RHS_FRAC_BITS>
     FixedPoint<INT_BITS, FRAC_BITS> &
         operator+=(const FixedPoint<RHS_INT_BITS,RHS_FRAC_BITS> &rhs) noexcept
     {
+        _FIXED_POINT_COUNT_OP(add,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
         this->num = this->get_num_sign_extended() + rhs.get_num_sign_extended();
-        this->round();
+        this->round_from<std::max(INT_BITS, RHS_INT_BITS)+1,
+                      std::max(FRAC_BITS, RHS_FRAC_BITS)>();
         return *this;
     }
     template <int RHS_INT_BITS, int RHS_FRAC_BITS>
@@ -328,17 +1143,23 @@ public:
         operator-(const FixedPoint<RHS_INT_BITS,RHS_FRAC_BITS> &rhs)
         const noexcept
     {
+        _FIXED_POINT_COUNT_OP(sub,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
         FixedPoint<INT_BITS, FRAC_BITS> res;
         res.num = this->get_num_sign_extended() - rhs.get_num_sign_extended();
-        res.round();
+        res.round_from<std::max(INT_BITS, RHS_INT_BITS)+1,
+                      std::max(FRAC_BITS, RHS_FRAC_BITS)>();
         return res;
     }
     template <int RHS_INT_BITS, int RHS_FRAC_BITS>
     FixedPoint<INT_BITS, FRAC_BITS> &
         operator-=(const FixedPoint<RHS_INT_BITS,RHS_FRAC_BITS> &rhs) noexcept
     {
+        _FIXED_POINT_COUNT_OP(sub,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
         this->num = this->get_num_sign_extended() - rhs.get_num_sign_extended();
-        this->round();
+        this->round_from<std::max(INT_BITS, RHS_INT_BITS)+1,
+                      std::max(FRAC_BITS, RHS_FRAC_BITS)>();
         return *this;
     }
 
@@ -360,36 +1181,37 @@ public:
         /*
          * Scenario 1:
          * The entire result of the multiplication can fit into one 64-bit
-         * integer. This code produces faster result when applicable.
+         * integer, that is, the operands have no more than 64 significant bits
+         * in total. The raw integers are multiplied and the product, which has
+         * FRAC_BITS+RHS_FRAC_BITS fractional bits, is shifted to the form
+         * Q(32,32). This code produces faster result when applicable.
          */
-        if (INT_BITS+FRAC_BITS <= 32 && RHS_INT_BITS+RHS_FRAC_BITS <= 32)
+        if (INT_BITS+FRAC_BITS + RHS_INT_BITS+RHS_FRAC_BITS <= 64)
         {
-            long long op_a{ this->get_num_sign_extended() >> INT_BITS     };
-            long long op_b{   rhs.get_num_sign_extended() >> RHS_INT_BITS };
-            res.num = op_a * op_b;
-
-            // Shift result to the correct place.
-            if (INT_BITS + RHS_INT_BITS > 32)
-            {
-                res.num <<= INT_BITS + RHS_INT_BITS - 32;
-            }
-            else
-            {
-                res.num >>= 32 - INT_BITS - RHS_INT_BITS;
-            }
-            res.round();
+            _FIXED_POINT_COUNT_OP(mul_scenario1,
+                    INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
+            using fixed_point_detail::shift_right;
+            long long prod{ this->get_raw() * rhs.get_raw() };
+            res.num = shift_right<FRAC_BITS+RHS_FRAC_BITS-32>(prod);
+            res.template round_from<INT_BITS+RHS_INT_BITS,
+                    std::min(FRAC_BITS+RHS_FRAC_BITS, 32)>();
             return res;
         }
         /*
          * Scenario 2:
          * The entire result of the multiplication can fit into one 128-bit
-         * integer. Running this code takes a little longer time than running
-         * the code of scenario 1, probably due to the fact that this code won't
-         * be accelerated by any integer vectorization. However, this piece of
-         * code seems to work for all sizes of FixedPoints.
+         * integer. Both operands are sign extended 64-bit integers, so the
+         * compiler emits a single widening (high-half) multiply rather than a
+         * full 128-bit multiplication. Running this code takes a little longer
+         * time than running the code of scenario 1, as the product has to be
+         * shifted across two registers, but it works for all sizes of
+         * FixedPoints.
          */
         else
         {
+            _FIXED_POINT_COUNT_OP(mul_scenario2,
+                    INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
+
             // Utilize the compiler extension of 128-bit wide integers to be
             // able to store the exact result.
             __extension__ __int128 op_a{ this->get_num_sign_extended() };
@@ -398,7 +1220,8 @@ public:
 
             // Shift result back to the form Q(32,32) and return result.
             res.num = static_cast<long long>(res_128 >> 32);
-            res.round();
+            res.template round_from<INT_BITS+RHS_INT_BITS,
+                    std::min(FRAC_BITS+RHS_FRAC_BITS, 32)>();
             return res;
         }
     }
@@ -426,14 +1249,23 @@ public:
         operator/(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
         const
     {
+        _FIXED_POINT_COUNT_OP(div,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
+
         // Note that Q(a,64) / Q(b,32) == Q(a-b,32).
         FixedPoint<INT_BITS, FRAC_BITS> res{};
         __extension__ __int128 dividend{ this->get_num_sign_extended() };
         __extension__ __int128 divisor {   rhs.get_num_sign_extended() };
         dividend <<= 32;
 
+        // Integer division rounds towards zero, but the quotient has to be
+        // rounded towards -INF before rounding it to FRAC_BITS bits.
+        __extension__ __int128 quotient{ dividend/divisor };
+        if ((dividend < 0) != (divisor < 0) && quotient*divisor != dividend)
+            --quotient;
+
         // Create and return result. Note that Q(a,64) / Q(b,32) == Q(c,32).
-        res.num = static_cast<long long>( dividend/divisor );
+        res.num = static_cast<long long>( quotient );
         res.round();
         return res;
     }
@@ -447,6 +1279,127 @@ public:
         return *this;
     }
 
+    /*
+     * Arithmetic with integers. The result equals that of the corresponding
+     * operator with a FixedPoint<32,0> right hand side operand, without
+     * constructing it. Multiplication is a single 64-bit multiply, as the
+     * product is exact in Q(32,32) modulo 2^64, and division by an integer
+     * needs no 128-bit division.
+     */
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<std::min(INT_BITS+32, 32), FRAC_BITS>
+        operator*(INT rhs) const noexcept
+    {
+        _FIXED_POINT_COUNT_OP(mul_scenario1, INT_BITS, FRAC_BITS, 32, 0);
+        FixedPoint<std::min(INT_BITS+32, 32), FRAC_BITS> res{};
+        res.num = this->mul_int(rhs);
+        res.template round_from<INT_BITS+32, FRAC_BITS>();
+        return res;
+    }
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<INT_BITS, FRAC_BITS> &operator*=(INT rhs) noexcept
+    {
+        _FIXED_POINT_COUNT_OP(mul_scenario1, INT_BITS, FRAC_BITS, 32, 0);
+        this->num = this->mul_int(rhs);
+        this->round_from<INT_BITS+32, FRAC_BITS>();
+        return *this;
+    }
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<INT_BITS, FRAC_BITS> operator/(INT rhs) const
+    {
+        _FIXED_POINT_COUNT_OP(div, INT_BITS, FRAC_BITS, 32, 0);
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        res.num = this->div_int(rhs);
+        res.round();
+        return res;
+    }
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<INT_BITS, FRAC_BITS> &operator/=(INT rhs)
+    {
+        _FIXED_POINT_COUNT_OP(div, INT_BITS, FRAC_BITS, 32, 0);
+        this->num = this->div_int(rhs);
+        this->round();
+        return *this;
+    }
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<INT_BITS, FRAC_BITS> operator+(INT rhs) const noexcept
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{ *this };
+        return res += rhs;
+    }
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<INT_BITS, FRAC_BITS> &operator+=(INT rhs) noexcept
+    {
+        _FIXED_POINT_COUNT_OP(add, INT_BITS, FRAC_BITS, 32, 0);
+        using uns_ll = unsigned long long;
+        this->num = static_cast<long long>(static_cast<uns_ll>(this->num) +
+                                           (static_cast<uns_ll>(rhs) << 32));
+        this->round_from<std::max(INT_BITS, 32)+1, FRAC_BITS>();
+        return *this;
+    }
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<INT_BITS, FRAC_BITS> operator-(INT rhs) const noexcept
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{ *this };
+        return res -= rhs;
+    }
+    template <typename INT, fixed_point_detail::if_integer<INT> = 0>
+    FixedPoint<INT_BITS, FRAC_BITS> &operator-=(INT rhs) noexcept
+    {
+        _FIXED_POINT_COUNT_OP(sub, INT_BITS, FRAC_BITS, 32, 0);
+        using uns_ll = unsigned long long;
+        this->num = static_cast<long long>(static_cast<uns_ll>(this->num) -
+                                           (static_cast<uns_ll>(rhs) << 32));
+        this->round_from<std::max(INT_BITS, 32)+1, FRAC_BITS>();
+        return *this;
+    }
+
+    /*
+     * Arithmetic shifts, that is, multiplication by 2^n and 2^-n for shift
+     * counts 0 <= n < 64. The word length is unchanged, so left shifts wrap
+     * around and right shifts round like every other operation.
+     */
+    FixedPoint<INT_BITS, FRAC_BITS> operator<<(int n) const noexcept
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{ *this };
+        return res <<= n;
+    }
+    FixedPoint<INT_BITS, FRAC_BITS> &operator<<=(int n) noexcept
+    {
+        using uns_ll = unsigned long long;
+        this->num = static_cast<long long>(static_cast<uns_ll>(this->num) << n);
+        this->round_from<32+1, FRAC_BITS>();
+        return *this;
+    }
+    FixedPoint<INT_BITS, FRAC_BITS> operator>>(int n) const noexcept
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{ *this };
+        return res >>= n;
+    }
+    FixedPoint<INT_BITS, FRAC_BITS> &operator>>=(int n) noexcept
+    {
+        // Bits shifted out below 2^-32 cannot change the rounded result.
+        this->num >>= n;
+        this->round();
+        return *this;
+    }
+
+    /*
+     * Multiplication by the constant 2^N, where N may be negative. With the
+     * shift known at compile time, the wrap around (N > 0) or the rounding
+     * (N < 0) is the only other work.
+     */
+    template <int N>
+    FixedPoint<INT_BITS, FRAC_BITS> mul_pow2() const noexcept
+    {
+        static_assert(N > -64 && N < 64,
+                "mul_pow2<N>() requires -64 < N < 64.");
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        res.num = fixed_point_detail::shift_right<-N>(this->num);
+        res.template round_from<INT_BITS+N, FRAC_BITS-N>();
+        return res;
+    }
+
     /*
      * Comparison operators.
      */
@@ -501,6 +1454,331 @@ std::ostream &operator<<(
     return os << rhs.to_string();
 }
 
+/*
+ * Integer times FixedPoint number, see FixedPoint::operator*(INT).
+ */
+template <typename INT, int INT_BITS, int FRAC_BITS,
+          fixed_point_detail::if_integer<INT> = 0>
+FixedPoint<std::min(INT_BITS+32, 32), FRAC_BITS>
+    operator*(INT lhs, const FixedPoint<INT_BITS, FRAC_BITS> &rhs) noexcept
+{
+    return rhs * lhs;
+}
+
+
+/*
+ * Canonical signed digit (CSD) representation of constants, that is, digits
+ * -1, 0 and 1 of which no two adjacent are non-zero. It has the fewest
+ * non-zero digits of all signed binary representations.
+ */
+namespace fixed_point_detail
+{
+    /*
+     * The part of 'raw' that remains after removing the CSD digits below
+     * position k, divided by 2^k.
+     */
+    constexpr literal_int csd_rest(long long raw, int k) noexcept
+    {
+        literal_int x{ raw };
+        for (int i=0; i<k; ++i)
+        {
+            if (x & 1)
+                x -= 2 - (x & 3);
+            x /= 2;
+        }
+        return x;
+    }
+
+    /*
+     * CSD digit at position k of 'raw'.
+     */
+    constexpr int csd_digit(long long raw, int k) noexcept
+    {
+        return (csd_rest(raw, k) & 1) ?
+            static_cast<int>(2 - (csd_rest(raw, k) & 3)) : 0;
+    }
+
+    /*
+     * Sum of the terms digit*(x << k) for the CSD digits of RAW from position
+     * K and up, modulo 2^(bits of UNS).
+     */
+    template <long long RAW, int K, typename UNS>
+    UNS csd_shift_add(UNS, std::false_type) noexcept
+    {
+        return 0;
+    }
+    template <long long RAW, int K, typename UNS>
+    UNS csd_shift_add(UNS x, std::true_type) noexcept
+    {
+        constexpr int DIGIT{ csd_digit(RAW, K) };
+        constexpr bool LAST{ csd_rest(RAW, K+1) == 0 };
+        constexpr int SHIFT{ K < 8*static_cast<int>(sizeof(UNS)) ? K : 0 };
+        UNS term{ K == SHIFT ? static_cast<UNS>(x << SHIFT) : UNS{ 0 } };
+        UNS rest{ csd_shift_add<RAW, K+1>(
+                x, std::integral_constant<bool, !LAST>{}) };
+        return DIGIT > 0 ? rest + term : DIGIT < 0 ? rest - term : rest;
+    }
+
+    /*
+     * Shift-add multiplication by the constant FixedPoint number with raw
+     * integer RAW, see mul_const().
+     */
+    struct const_multiplier
+    {
+        template <int RHS_INT_BITS, int RHS_FRAC_BITS, long long RAW,
+                  int INT_BITS, int FRAC_BITS>
+        static FixedPoint<std::min(INT_BITS+RHS_INT_BITS, 32),
+                          std::min(FRAC_BITS+RHS_FRAC_BITS, 32)>
+            shift_add(const FixedPoint<INT_BITS, FRAC_BITS> &x) noexcept
+        {
+            _FIXED_POINT_COUNT_OP(mul_const,
+                    INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
+            constexpr int PROD_FRAC_BITS{ FRAC_BITS+RHS_FRAC_BITS };
+            FixedPoint<std::min(INT_BITS+RHS_INT_BITS, 32),
+                       std::min(PROD_FRAC_BITS, 32)> res{};
+
+            /*
+             * The product either fits in 64 bits, or it is needed modulo
+             * 2^64 only, as it is not shifted to the right. Otherwise the
+             * terms are summed in 128 bits.
+             */
+            if (INT_BITS+FRAC_BITS + RHS_INT_BITS+RHS_FRAC_BITS <= 64 ||
+                PROD_FRAC_BITS <= 32)
+            {
+                using uns_ll = unsigned long long;
+                uns_ll prod{ csd_shift_add<RAW, 0>(
+                        static_cast<uns_ll>(x.get_raw()), std::true_type{}) };
+                res.num = shift_right<PROD_FRAC_BITS-32>(
+                        static_cast<long long>(prod));
+            }
+            else
+            {
+                __extension__ typedef unsigned __int128 uns_128;
+                __extension__ typedef __int128 int_128;
+                constexpr int SHIFT{
+                    PROD_FRAC_BITS > 32 ? PROD_FRAC_BITS-32 : 0 };
+                uns_128 prod{ csd_shift_add<RAW, 0>(
+                        static_cast<uns_128>(int_128{ x.get_raw() }),
+                        std::true_type{}) };
+                res.num = static_cast<long long>(
+                        static_cast<int_128>(prod) >> SHIFT);
+            }
+            res.template round_from<INT_BITS+RHS_INT_BITS,
+                    std::min(PROD_FRAC_BITS, 32)>();
+            return res;
+        }
+    };
+}
+
+/*
+ * Number of non-zero CSD digits of a raw constant. A hardware multiplier by
+ * the constant needs one adder or subtractor less than that.
+ */
+constexpr int fixed_point_csd_digits(long long raw) noexcept
+{
+    int digits{ 0 };
+    for (int k=0; fixed_point_detail::csd_rest(raw, k) != 0; ++k)
+        digits += fixed_point_detail::csd_digit(raw, k) != 0;
+    return digits;
+}
+
+/*
+ * Constants with at most this many non-zero CSD digits are multiplied by
+ * shifts and additions in mul_const(). Define it before including this header
+ * to match the target, e.g, a large number for targets without a multiplier.
+ */
+#ifndef _FIXED_POINT_CSD_MAX_DIGITS
+    #define _FIXED_POINT_CSD_MAX_DIGITS 3
+#endif
+
+/*
+ * Multiplication by the constant FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS>
+ * number with raw integer RAW, e.g, 'mul_const<1,15,9830>(x)' for 0.3. The
+ * result, including its format and rounding, equals that of operator*, but
+ * constants with few non-zero CSD digits are multiplied by a sequence of
+ * shifts and additions, just like a hardware constant multiplier.
+ */
+template <int RHS_INT_BITS, int RHS_FRAC_BITS, long long RAW,
+          int INT_BITS, int FRAC_BITS>
+FixedPoint<std::min(INT_BITS+RHS_INT_BITS, 32),
+           std::min(FRAC_BITS+RHS_FRAC_BITS, 32)>
+    mul_const(const FixedPoint<INT_BITS, FRAC_BITS> &x) noexcept
+{
+    constexpr int RHS_BITS{ RHS_INT_BITS+RHS_FRAC_BITS };
+    static_assert(RHS_BITS > 0 && RHS_BITS <= 64 && (RHS_BITS == 64 ||
+                  (RAW >= -(1ll << (RHS_BITS < 64 ? RHS_BITS-1 : 0)) &&
+                   RAW < (1ll << (RHS_BITS < 64 ? RHS_BITS-1 : 0)))),
+            "Constant does not fit in the FixedPoint format.");
+    if (fixed_point_csd_digits(RAW) <= _FIXED_POINT_CSD_MAX_DIGITS)
+    {
+        return fixed_point_detail::const_multiplier::shift_add<
+                RHS_INT_BITS, RHS_FRAC_BITS, RAW>(x);
+    }
+    FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> c{};
+    c.set_raw(RAW);
+    return x * c;
+}
+
+/*
+ * Multiplication by a constant literal, rounded to the format
+ * FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS>, e.g, 'mul_const<1,15>(x, 0.3_fxp)'.
+ */
+template <int RHS_INT_BITS, int RHS_FRAC_BITS,
+          long long MANTISSA, int EXPONENT, int INT_BITS, int FRAC_BITS>
+FixedPoint<std::min(INT_BITS+RHS_INT_BITS, 32),
+           std::min(FRAC_BITS+RHS_FRAC_BITS, 32)>
+    mul_const(const FixedPoint<INT_BITS, FRAC_BITS> &x,
+              FixedPointLiteral<MANTISSA, EXPONENT>) noexcept
+{
+    static_assert(RHS_FRAC_BITS >= 0,
+            "Literals need a non-negative number of fractional bits.");
+    constexpr fixed_point_detail::literal_int RAW{
+        fixed_point_detail::literal_raw(MANTISSA, EXPONENT, RHS_FRAC_BITS) };
+    static_assert(fixed_point_detail::literal_fits(
+                      RAW, RHS_INT_BITS+RHS_FRAC_BITS),
+            "Literal does not fit in the FixedPoint format.");
+    return mul_const<RHS_INT_BITS, RHS_FRAC_BITS,
+                     static_cast<long long>(RAW)>(x);
+}
+
+
+/*
+ * Storage integer type for raw FixedPoint numbers, the narrowest signed integer
+ * with room for BITS bits.
+ */
+namespace fixed_point_detail
+{
+    template <int BITS>
+    struct storage_int
+    {
+        using type =
+            typename std::conditional<(BITS <= 8),  std::int8_t,
+            typename std::conditional<(BITS <= 16), std::int16_t,
+            typename std::conditional<(BITS <= 32), std::int32_t,
+                                      std::int64_t>::type>::type>::type;
+    };
+}
+
+
+/*
+ * Type FixedPointSpan begin.
+ *
+ * Non-owning view of existing integer memory as a sequence of FixedPoint
+ * numbers, where each integer holds the raw value (see FixedPoint::get_raw())
+ * of one number. Nothing is copied, elements are converted to and from
+ * FixedPoint numbers on access. Use a const StorageInt for read-only views.
+ *
+ * Example, a DMA buffer of Q(1,15) samples:
+ *
+ *     int16_t *dma_buffer = ...;
+ *     FixedPointSpan<1,15,int16_t> samples{ dma_buffer, n };
+ *     FixedPoint<1,15> first = samples[0];
+ *     samples[1] = first * first;
+ */
+template <
+    int INT_BITS, int FRAC_BITS,
+    typename StorageInt =
+        typename fixed_point_detail::storage_int<INT_BITS+FRAC_BITS>::type>
+class FixedPointSpan
+{
+    using storage_type = typename std::remove_const<StorageInt>::type;
+    static_assert(std::is_integral<storage_type>::value &&
+                  std::is_signed<storage_type>::value,
+            "FixedPointSpan storage needs to be a signed integer type.");
+    static_assert(INT_BITS + FRAC_BITS <= 8*sizeof(StorageInt),
+            "FixedPointSpan storage too narrow for the FixedPoint type.");
+
+public:
+    using value_type = FixedPoint<INT_BITS, FRAC_BITS>;
+
+    /*
+     * Proxy reference to a single element of the view.
+     */
+    class reference
+    {
+    public:
+        explicit reference(StorageInt *p) noexcept : p(p) {}
+        reference(const reference &) = default;
+
+        operator value_type() const noexcept
+        {
+            value_type res{};
+            res.set_raw(*this->p);
+            return res;
+        }
+
+        template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+        reference &
+            operator=(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+            noexcept
+        {
+            // Conversion to the element format performs the rounding.
+            value_type value{ rhs };
+            *this->p = static_cast<storage_type>(value.get_raw());
+            return *this;
+        }
+        reference &operator=(const reference &rhs) noexcept
+        {
+            return *this = static_cast<value_type>(rhs);
+        }
+
+    private:
+        StorageInt *p;
+    };
+
+    FixedPointSpan() noexcept : ptr{ nullptr }, len{} {}
+    FixedPointSpan(StorageInt *data, std::size_t size) noexcept
+        : ptr{ data }, len{ size } {}
+
+    /*
+     * Size and underlying integer memory of the view.
+     */
+    std::size_t size() const noexcept { return this->len; }
+    bool empty() const noexcept { return this->len == 0; }
+    StorageInt *data() const noexcept { return this->ptr; }
+
+    /*
+     * Element access.
+     */
+    reference operator[](std::size_t i) const noexcept
+    {
+        return reference{ this->ptr + i };
+    }
+    value_type get(std::size_t i) const noexcept
+    {
+        value_type res{};
+        res.set_raw(this->ptr[i]);
+        return res;
+    }
+    void set(std::size_t i, const value_type &value) const noexcept
+    {
+        this->ptr[i] = static_cast<storage_type>(value.get_raw());
+    }
+
+    /*
+     * View of 'count' elements starting at element 'offset'.
+     */
+    FixedPointSpan subspan(std::size_t offset, std::size_t count) const
+        noexcept
+    {
+        return FixedPointSpan{ this->ptr + offset, count };
+    }
+
+private:
+    StorageInt *ptr;
+    std::size_t len;
+};
+
+/*
+ * Create a FixedPointSpan with storage type deduced from the buffer.
+ */
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt>
+    make_fixed_point_span(StorageInt *data, std::size_t size) noexcept
+{
+    return FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt>{ data, size };
+}
+
 /*
  * Include guard end.
  */
@@ -0,0 +1,288 @@
+/*
+ * PoorMansFixedPoint atomics extension. FixedPoint numbers have a virtual
+ * destructor, so std::atomic<FixedPoint<INT_BITS, FRAC_BITS>> is not an
+ * option. An AtomicFixedPoint number instead keeps the raw integer in a
+ * std::atomic<long long>, shifted all the way to the left such that the sign
+ * bit of the format is the MSb. Two's complement addition of such integers
+ * wraps around exactly like the FixedPoint format does, and as the value is a
+ * multiple of 2^-FRAC_BITS, rounding the sum of it and an addend is the same
+ * as adding the rounded addend:
+ *
+ *     round(x + y) == x + round(y)
+ *
+ * Hence fetch_add() and fetch_sub() are a single lock-free atomic addition,
+ * with the same rounding and wrap around as FixedPoint::operator+=(), and no
+ * compare-and-swap loop.
+ *
+ * For counters that many threads add to, ShardedFixedPointAccumulator spreads
+ * the additions over several atomics on separate cache lines. As addition
+ * with wrap around is associative, the total equals that of adding every
+ * value to a single FixedPoint number, in any order.
+ *
+ * Everything in here is built on top of the public interface of FixedPoint.h,
+ * and the core header does not depend on this one.
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_ATOMIC_H
+#define _POOR_MANS_FIXED_POINT_ATOMIC_H
+
+#include "FixedPoint.h"
+#include <atomic>
+#include <cstddef>
+
+
+/*
+ * Type AtomicFixedPoint begin.
+ */
+template <int INT_BITS, int FRAC_BITS>
+class AtomicFixedPoint
+{
+    static_assert(INT_BITS + FRAC_BITS > 0,
+            "Need at least one bit of representation.");
+
+    /*
+     * Left shift which puts the sign bit of the format in the MSb.
+     */
+    static constexpr int ALIGN_SHIFT{ 64 - (INT_BITS+FRAC_BITS) };
+
+    /*
+     * The raw integer of the number shifted left by ALIGN_SHIFT bits.
+     */
+    std::atomic<long long> aligned_raw{ 0 };
+
+    static long long align(const FixedPoint<INT_BITS, FRAC_BITS> &x) noexcept
+    {
+        using uns_ll = unsigned long long;
+        return static_cast<long long>(
+                static_cast<uns_ll>(x.get_raw()) << ALIGN_SHIFT);
+    }
+
+    static FixedPoint<INT_BITS, FRAC_BITS> unalign(long long aligned) noexcept
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        res.set_raw(aligned >> ALIGN_SHIFT);
+        return res;
+    }
+
+    /*
+     * The addend of 'rhs', rounded to FRAC_BITS fractional bits like in
+     * FixedPoint::operator+=(). Bits above those of Q(32,FRAC_BITS) would be
+     * wrapped away anyway.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    static long long addend(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        FixedPoint<32, FRAC_BITS> rounded{ rhs };
+        using uns_ll = unsigned long long;
+        return static_cast<long long>(
+                static_cast<uns_ll>(rounded.get_raw()) << ALIGN_SHIFT);
+    }
+
+public:
+    AtomicFixedPoint() noexcept = default;
+    explicit AtomicFixedPoint(const FixedPoint<INT_BITS, FRAC_BITS> &x)
+        noexcept
+        : aligned_raw{ align(x) }
+    {
+    }
+    AtomicFixedPoint(const AtomicFixedPoint &) = delete;
+    AtomicFixedPoint &operator=(const AtomicFixedPoint &) = delete;
+
+    /*
+     * Get template arguments from AtomicFixedPoint.
+     */
+    constexpr int get_int_bits() const noexcept { return INT_BITS; }
+    constexpr int get_frac_bits() const noexcept { return FRAC_BITS; }
+
+    bool is_lock_free() const noexcept
+    {
+        return this->aligned_raw.is_lock_free();
+    }
+
+    /*
+     * Atomic load, store and exchange.
+     */
+    FixedPoint<INT_BITS, FRAC_BITS>
+        load(std::memory_order order=std::memory_order_seq_cst) const noexcept
+    {
+        return unalign(this->aligned_raw.load(order));
+    }
+    void store(const FixedPoint<INT_BITS, FRAC_BITS> &x,
+               std::memory_order order=std::memory_order_seq_cst) noexcept
+    {
+        this->aligned_raw.store(align(x), order);
+    }
+    FixedPoint<INT_BITS, FRAC_BITS>
+        exchange(const FixedPoint<INT_BITS, FRAC_BITS> &x,
+                 std::memory_order order=std::memory_order_seq_cst) noexcept
+    {
+        return unalign(this->aligned_raw.exchange(align(x), order));
+    }
+
+    /*
+     * Atomic addition and subtraction of FixedPoint numbers of any format,
+     * returning the previous value. The result is rounded and wraps around
+     * just like that of operator+=() and operator-=().
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    FixedPoint<INT_BITS, FRAC_BITS>
+        fetch_add(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs,
+                  std::memory_order order=std::memory_order_seq_cst) noexcept
+    {
+        _FIXED_POINT_COUNT_OP(add,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
+        return unalign(this->aligned_raw.fetch_add(addend(rhs), order));
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    FixedPoint<INT_BITS, FRAC_BITS>
+        fetch_sub(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs,
+                  std::memory_order order=std::memory_order_seq_cst) noexcept
+    {
+        _FIXED_POINT_COUNT_OP(sub,
+                INT_BITS, FRAC_BITS, RHS_INT_BITS, RHS_FRAC_BITS);
+
+        // Ties round upwards, so round(x - y) is x + round(-y), and not
+        // x - round(y). The raw integer is negated in unsigned arithmetic,
+        // as -2^31 in Q(32,32) has no signed negation. It wraps around only
+        // in bits that are wrapped away anyway.
+        using uns_ll = unsigned long long;
+        FixedPoint<32, RHS_FRAC_BITS> neg{ rhs };
+        neg.set_raw(static_cast<long long>(
+                0ull - static_cast<uns_ll>(neg.get_raw())));
+        return unalign(this->aligned_raw.fetch_add(addend(neg), order));
+    }
+
+    /*
+     * Atomic compare-and-swap. On failure, 'expected' is set to the current
+     * value.
+     */
+    bool compare_exchange_weak(
+            FixedPoint<INT_BITS, FRAC_BITS> &expected,
+            const FixedPoint<INT_BITS, FRAC_BITS> &desired,
+            std::memory_order success=std::memory_order_seq_cst,
+            std::memory_order failure=std::memory_order_seq_cst) noexcept
+    {
+        long long aligned_expected{ align(expected) };
+        bool res{ this->aligned_raw.compare_exchange_weak(
+                aligned_expected, align(desired), success, failure) };
+        expected = unalign(aligned_expected);
+        return res;
+    }
+    bool compare_exchange_strong(
+            FixedPoint<INT_BITS, FRAC_BITS> &expected,
+            const FixedPoint<INT_BITS, FRAC_BITS> &desired,
+            std::memory_order success=std::memory_order_seq_cst,
+            std::memory_order failure=std::memory_order_seq_cst) noexcept
+    {
+        long long aligned_expected{ align(expected) };
+        bool res{ this->aligned_raw.compare_exchange_strong(
+                aligned_expected, align(desired), success, failure) };
+        expected = unalign(aligned_expected);
+        return res;
+    }
+};
+
+
+namespace fixed_point_detail
+{
+    /*
+     * Assumed size of a cache line, in bytes.
+     */
+    constexpr std::size_t cache_line_size{ 64 };
+
+    /*
+     * Shard of the calling thread. Threads get consecutive indices on first
+     * use, such that up to SHARDS threads never share a shard.
+     */
+    inline unsigned thread_shard() noexcept
+    {
+        static std::atomic<unsigned> next{ 0 };
+        static thread_local unsigned shard{
+            next.fetch_add(1, std::memory_order_relaxed) };
+        return shard;
+    }
+}
+
+
+/*
+ * Sharded accumulator for FixedPoint counters with many concurrent writers,
+ * e.g, statistics of a multi-threaded ingestion. Every thread adds into its
+ * own shard, padded to a cache line, with relaxed atomics, so additions do
+ * not contend unless more than SHARDS threads add concurrently.
+ *
+ * The value of the accumulator is the sum of the shards. It equals that of
+ * adding every value to one FixedPoint number, but while other threads are
+ * adding, it is not a snapshot of any single moment.
+ */
+template <int INT_BITS, int FRAC_BITS, unsigned SHARDS=16>
+class ShardedFixedPointAccumulator
+{
+    static_assert(SHARDS > 0, "Need at least one shard.");
+
+    /*
+     * Shards are 64 bytes apart, and so on separate cache lines even when
+     * the accumulator is allocated with smaller alignment.
+     */
+    struct alignas(fixed_point_detail::cache_line_size) Shard
+    {
+        AtomicFixedPoint<INT_BITS, FRAC_BITS> value{};
+    };
+    static_assert(sizeof(Shard) == fixed_point_detail::cache_line_size,
+            "Shards need to be exactly one cache line.");
+
+    Shard shards[SHARDS]{};
+
+    AtomicFixedPoint<INT_BITS, FRAC_BITS> &own_shard() noexcept
+    {
+        return this->shards[fixed_point_detail::thread_shard() % SHARDS].value;
+    }
+
+public:
+    ShardedFixedPointAccumulator() noexcept = default;
+    ShardedFixedPointAccumulator(const ShardedFixedPointAccumulator &) =
+        delete;
+    ShardedFixedPointAccumulator &operator=(
+            const ShardedFixedPointAccumulator &) = delete;
+
+    /*
+     * Add or subtract a FixedPoint number of any format, rounded like
+     * operator+=() and operator-=().
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    void add(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs) noexcept
+    {
+        this->own_shard().fetch_add(rhs, std::memory_order_relaxed);
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    void sub(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs) noexcept
+    {
+        this->own_shard().fetch_sub(rhs, std::memory_order_relaxed);
+    }
+
+    /*
+     * Sum of all shards.
+     */
+    FixedPoint<INT_BITS, FRAC_BITS> load() const noexcept
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        for (const Shard &shard : this->shards)
+            res += shard.value.load(std::memory_order_relaxed);
+        return res;
+    }
+
+    /*
+     * Set all shards to zero. Additions concurrent with the reset may or may
+     * not be included in the new value.
+     */
+    void reset() noexcept
+    {
+        for (Shard &shard : this->shards)
+            shard.value.store(FixedPoint<INT_BITS, FRAC_BITS>{},
+                              std::memory_order_relaxed);
+    }
+};
+
+#endif
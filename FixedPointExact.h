@@ -0,0 +1,404 @@
+/*
+ * PoorMansFixedPoint exact arithmetic extension. The result of an operation on
+ * ExactFixedPoint numbers is never rounded nor wrapped around, instead the
+ * result format grows to hold the exact result:
+ *
+ *     a + b, a - b  ->  Q(max(INT_BITS)+1, max(FRAC_BITS))
+ *     a * b         ->  Q(INT_BITS+RHS_INT_BITS, FRAC_BITS+RHS_FRAC_BITS)
+ *     -a            ->  Q(INT_BITS+1, FRAC_BITS)
+ *
+ * Numbers are stored as raw integers in the narrowest signed integer with room
+ * for the format, at most 128 bits, so a format is not limited to Q(32,32) as
+ * for FixedPoint numbers. No rounding happens until the result is explicitly
+ * narrowed to a FixedPoint number with round_to(), which mirrors how datapaths
+ * are designed in hardware: full precision products and sums, and a single
+ * quantization at the output.
+ *
+ *     FixedPoint<1,15> x = ..., h = ...;
+ *     ExactFixedPoint<8,30> acc{};
+ *     for (...)
+ *         acc += make_exact_fixed_point(x) * make_exact_fixed_point(h);
+ *     FixedPoint<1,15> y = acc.round_to<1,15>();
+ *
+ * Accumulators of a fixed format are updated with the compound operators += and
+ * -=, which wrap around on overflow like FixedPoint numbers do, but never
+ * round, the right hand side may not have more fractional bits than the
+ * accumulator. Division is not supported, as its result is not exact.
+ *
+ * Everything in here is built on top of the public interface of FixedPoint.h,
+ * and the core header does not depend on this one.
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_EXACT_H
+#define _POOR_MANS_FIXED_POINT_EXACT_H
+
+#include "FixedPoint.h"
+#include <cmath>
+#include <algorithm>
+#include <type_traits>
+
+
+namespace fixed_point_detail
+{
+    __extension__ typedef __int128 exact_int128;
+    __extension__ typedef unsigned __int128 exact_uint128;
+
+    /*
+     * Storage integer type for ExactFixedPoint numbers, the narrowest signed
+     * integer with room for BITS bits, and the integer type arithmetic on
+     * such numbers is carried out in.
+     */
+    template <int BITS>
+    struct exact_int
+    {
+        using storage_type =
+            typename std::conditional<(BITS <= 64),
+                typename storage_int<BITS>::type, exact_int128>::type;
+        using work_type =
+            typename std::conditional<(BITS <= 64),
+                long long, exact_int128>::type;
+    };
+
+    /*
+     * Multiply 'x' by 2^N, N >= 0, without shifting a negative number.
+     */
+    template <int N, typename T>
+    constexpr T scale_up(T x) noexcept
+    {
+        return x * (static_cast<T>(1) << N);
+    }
+
+    /*
+     * Wrap 'x' around to BITS bits, see FixedPoint::wrap().
+     */
+    template <int BITS>
+    constexpr long long wrap_bits(long long x) noexcept
+    {
+        using uns_ll = unsigned long long;
+        return BITS >= 64 ? x : static_cast<long long>(
+                static_cast<uns_ll>(x) << (BITS < 64 ? 64-BITS : 0))
+                    >> (BITS < 64 ? 64-BITS : 0);
+    }
+    template <int BITS>
+    constexpr exact_int128 wrap_bits(exact_int128 x) noexcept
+    {
+        return BITS >= 128 ? x : static_cast<exact_int128>(
+                static_cast<exact_uint128>(x) << (BITS < 128 ? 128-BITS : 0))
+                    >> (BITS < 128 ? 128-BITS : 0);
+    }
+
+    /*
+     * Round raw integer 'x' with FRAC_BITS fractional bits to RES_FRAC_BITS
+     * fractional bits, if fewer, like FixedPoint::round() does: to nearest
+     * with ties upwards, or towards -INF if RES_FRAC_BITS is 32. Computed as
+     * floor(x/2^SHIFT) plus the bit below, so 'x' never overflows.
+     */
+    template <int FRAC_BITS, int RES_FRAC_BITS, typename T>
+    constexpr T round_raw(T x) noexcept
+    {
+        return FRAC_BITS <= RES_FRAC_BITS ? x :
+            (x >> (FRAC_BITS > RES_FRAC_BITS ? FRAC_BITS-RES_FRAC_BITS : 0)) +
+            (RES_FRAC_BITS < 32 ?
+                (x >> (FRAC_BITS > RES_FRAC_BITS ?
+                       FRAC_BITS-RES_FRAC_BITS-1 : 0)) & 1 : 0);
+    }
+}
+
+
+/*
+ * Type ExactFixedPoint begin.
+ */
+template <int INT_BITS, int FRAC_BITS>
+class ExactFixedPoint
+{
+    static_assert(INT_BITS + FRAC_BITS > 0,
+            "Need at least one bit of representation.");
+    static_assert(INT_BITS + FRAC_BITS <= 128,
+            "ExactFixedPoint numbers are limited to 128 bits.");
+
+public:
+    using storage_type = typename fixed_point_detail::exact_int<
+        INT_BITS+FRAC_BITS>::storage_type;
+
+private:
+    using work_type = typename fixed_point_detail::exact_int<
+        INT_BITS+FRAC_BITS>::work_type;
+
+    /*
+     * The number scaled by 2^FRAC_BITS. It always fits in INT_BITS+FRAC_BITS
+     * bits.
+     */
+    storage_type raw{};
+
+    /*
+     * Friend declaration for accessing 'raw' between different formats.
+     */
+    template <int _INT_BITS, int _FRAC_BITS>
+    friend class ExactFixedPoint;
+
+    /*
+     * The raw integer of this number, as an integer of type T, scaled to
+     * ALIGN_FRAC_BITS >= FRAC_BITS fractional bits.
+     */
+    template <int ALIGN_FRAC_BITS, typename T>
+    constexpr T aligned() const noexcept
+    {
+        static_assert(ALIGN_FRAC_BITS >= FRAC_BITS,
+                "Alignment would discard fractional bits.");
+        return fixed_point_detail::scale_up<ALIGN_FRAC_BITS-FRAC_BITS>(
+                static_cast<T>(this->raw));
+    }
+
+    /*
+     * Create a number from a raw integer which is known to fit in
+     * INT_BITS+FRAC_BITS bits, e.g, the exact result of an operation.
+     */
+    static constexpr ExactFixedPoint exact_from_raw(work_type raw) noexcept
+    {
+        ExactFixedPoint res{};
+        res.raw = static_cast<storage_type>(raw);
+        return res;
+    }
+
+public:
+    constexpr ExactFixedPoint() noexcept = default;
+
+    /*
+     * Exact initialization from FixedPoint numbers with no more integer and
+     * fractional bits.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    explicit ExactFixedPoint(const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        static_assert(RHS_INT_BITS <= INT_BITS && RHS_FRAC_BITS <= FRAC_BITS,
+                "Initialization from a wider FixedPoint number is not exact.");
+        this->raw = static_cast<storage_type>(
+                fixed_point_detail::scale_up<FRAC_BITS-RHS_FRAC_BITS>(
+                    static_cast<work_type>(rhs.get_raw())));
+    }
+
+    /*
+     * Exact, widening, initialization from other ExactFixedPoint numbers.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr ExactFixedPoint(
+            const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs) noexcept
+        : raw{ static_cast<storage_type>(
+                rhs.template aligned<FRAC_BITS, work_type>()) }
+    {
+        static_assert(RHS_INT_BITS <= INT_BITS && RHS_FRAC_BITS <= FRAC_BITS,
+                "Initialization from a wider ExactFixedPoint number is not "
+                "exact, use round_to() to narrow it.");
+    }
+    constexpr ExactFixedPoint(const ExactFixedPoint &rhs) noexcept = default;
+    ExactFixedPoint &operator=(const ExactFixedPoint &rhs) noexcept = default;
+
+    /*
+     * Create a number from its raw integer, the number scaled by 2^FRAC_BITS.
+     * Bits that do not fit into INT_BITS+FRAC_BITS bits are truncated.
+     */
+    static constexpr ExactFixedPoint from_raw(work_type raw) noexcept
+    {
+        return exact_from_raw(
+                fixed_point_detail::wrap_bits<INT_BITS+FRAC_BITS>(raw));
+    }
+
+    /*
+     * Get template arguments and the raw integer of the number.
+     */
+    constexpr int get_int_bits() const noexcept { return INT_BITS; }
+    constexpr int get_frac_bits() const noexcept { return FRAC_BITS; }
+    constexpr storage_type get_raw() const noexcept { return this->raw; }
+
+    /*
+     * Narrow the number to a FixedPoint number. This is where rounding and
+     * wrap around happens, with the same semantics as the conversion between
+     * FixedPoint numbers: round to nearest with ties upwards, or towards -INF
+     * for numbers with 32 fractional bits, and two's complement wrap around.
+     * The result is rounded once, which may differ from rounding it in
+     * several steps as a chain of FixedPoint operations does.
+     */
+    template <int RES_INT_BITS, int RES_FRAC_BITS>
+    FixedPoint<RES_INT_BITS, RES_FRAC_BITS> round_to() const noexcept
+    {
+        constexpr int LEFT = std::max(RES_FRAC_BITS - FRAC_BITS, 0);
+        work_type res_raw{ fixed_point_detail::round_raw<
+            FRAC_BITS, RES_FRAC_BITS>(static_cast<work_type>(this->raw)) };
+
+        // Only the bits that fit in the result are kept.
+        using uns_ll = unsigned long long;
+        FixedPoint<RES_INT_BITS, RES_FRAC_BITS> res{};
+        res.set_raw(static_cast<long long>(
+                static_cast<uns_ll>(res_raw) << LEFT));
+        return res;
+    }
+
+    /*
+     * (explicit) Conversion to floating point number. The conversion is exact
+     * for numbers of up to 53 bits.
+     */
+    explicit operator double() const noexcept
+    {
+        return std::ldexp(static_cast<double>(this->raw), -FRAC_BITS);
+    }
+
+    /*
+     * Unary negation operator.
+     */
+    constexpr ExactFixedPoint<INT_BITS+1, FRAC_BITS> operator-() const noexcept
+    {
+        using res_type = ExactFixedPoint<INT_BITS+1, FRAC_BITS>;
+        using work = typename res_type::work_type;
+        return res_type::exact_from_raw(-static_cast<work>(this->raw));
+    }
+
+    /*
+     * Addition/subtraction of ExactFixedPoint numbers. The result has one more
+     * integer bit than the widest operand, and as many fractional bits as the
+     * operand with the most fractional bits.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr ExactFixedPoint<std::max(INT_BITS, RHS_INT_BITS)+1,
+                              std::max(FRAC_BITS, RHS_FRAC_BITS)>
+        operator+(const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        constexpr int RES_FRAC_BITS = std::max(FRAC_BITS, RHS_FRAC_BITS);
+        using res_type = ExactFixedPoint<std::max(INT_BITS, RHS_INT_BITS)+1,
+                                         RES_FRAC_BITS>;
+        using work = typename res_type::work_type;
+        return res_type::exact_from_raw(
+                this->template aligned<RES_FRAC_BITS, work>() +
+                  rhs.template aligned<RES_FRAC_BITS, work>());
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr ExactFixedPoint<std::max(INT_BITS, RHS_INT_BITS)+1,
+                              std::max(FRAC_BITS, RHS_FRAC_BITS)>
+        operator-(const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        constexpr int RES_FRAC_BITS = std::max(FRAC_BITS, RHS_FRAC_BITS);
+        using res_type = ExactFixedPoint<std::max(INT_BITS, RHS_INT_BITS)+1,
+                                         RES_FRAC_BITS>;
+        using work = typename res_type::work_type;
+        return res_type::exact_from_raw(
+                this->template aligned<RES_FRAC_BITS, work>() -
+                  rhs.template aligned<RES_FRAC_BITS, work>());
+    }
+
+    /*
+     * Accumulation into a number of fixed format. The sum wraps around on
+     * overflow, but it is never rounded.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    ExactFixedPoint<INT_BITS, FRAC_BITS> &
+        operator+=(const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        static_assert(RHS_FRAC_BITS <= FRAC_BITS,
+                "Accumulation of more fractional bits is not exact.");
+        using work = typename fixed_point_detail::exact_int<
+            std::max(INT_BITS, RHS_INT_BITS)+FRAC_BITS>::work_type;
+        this->raw = static_cast<storage_type>(
+                fixed_point_detail::wrap_bits<INT_BITS+FRAC_BITS>(
+                    this->template aligned<FRAC_BITS, work>() +
+                      rhs.template aligned<FRAC_BITS, work>()));
+        return *this;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    ExactFixedPoint<INT_BITS, FRAC_BITS> &
+        operator-=(const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        static_assert(RHS_FRAC_BITS <= FRAC_BITS,
+                "Accumulation of more fractional bits is not exact.");
+        using work = typename fixed_point_detail::exact_int<
+            std::max(INT_BITS, RHS_INT_BITS)+FRAC_BITS>::work_type;
+        this->raw = static_cast<storage_type>(
+                fixed_point_detail::wrap_bits<INT_BITS+FRAC_BITS>(
+                    this->template aligned<FRAC_BITS, work>() -
+                      rhs.template aligned<FRAC_BITS, work>()));
+        return *this;
+    }
+
+    /*
+     * Multiplication of ExactFixedPoint numbers. The result has the sum of the
+     * integer and the sum of the fractional bits of the operands.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr ExactFixedPoint<INT_BITS+RHS_INT_BITS, FRAC_BITS+RHS_FRAC_BITS>
+        operator*(const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        using res_type = ExactFixedPoint<INT_BITS+RHS_INT_BITS,
+                                         FRAC_BITS+RHS_FRAC_BITS>;
+        using work = typename res_type::work_type;
+        return res_type::exact_from_raw(
+                static_cast<work>(this->raw) * static_cast<work>(rhs.raw));
+    }
+
+    /*
+     * Comparison operators.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr bool operator==(
+            const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return (*this - rhs).get_raw() == 0;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr bool operator!=(
+            const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return (*this - rhs).get_raw() != 0;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr bool operator<(
+            const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return (*this - rhs).get_raw() < 0;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr bool operator<=(
+            const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return (*this - rhs).get_raw() <= 0;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr bool operator>(
+            const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return (*this - rhs).get_raw() > 0;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    constexpr bool operator>=(
+            const ExactFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return (*this - rhs).get_raw() >= 0;
+    }
+};
+
+
+/*
+ * Create an ExactFixedPoint number of the same format as a FixedPoint number.
+ */
+template <int INT_BITS, int FRAC_BITS>
+ExactFixedPoint<INT_BITS, FRAC_BITS>
+    make_exact_fixed_point(const FixedPoint<INT_BITS, FRAC_BITS> &x) noexcept
+{
+    return ExactFixedPoint<INT_BITS, FRAC_BITS>{ x };
+}
+
+/*
+ * Include guard end.
+ */
+#endif
@@ -0,0 +1,1117 @@
+/*
+ * PoorMansFixedPoint I/O extensions. This header contains facilities for
+ * moving large amounts of FixedPoint numbers in and out of a program, e.g.,
+ * when exporting test vectors for comparison with MATLAB or RTL simulators.
+ *
+ * Everything in here is built on top of the public interface of FixedPoint.h,
+ * and the core header does not depend on this one.
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_IO_H
+#define _POOR_MANS_FIXED_POINT_IO_H
+
+#include "FixedPoint.h"
+#include "FixedPointReduce.h"
+#include <ostream>
+#include <istream>
+#include <stdexcept>
+#include <vector>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <cctype>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+
+#if defined(__unix__) || defined(__APPLE__)
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+
+
+/*
+ * Text formats supported by the FixedPointTextWriter.
+ */
+enum class FixedPointTextFormat
+{
+    decimal,    // Exact decimal expansion of the number, e.g, "-19.125".
+    raw_hex,    // Two's complement bit pattern, e.g, "0x3b38" for Q(10,4).
+    quotient    // Same form as FixedPoint::to_string(), e.g, "-20 + 7/8".
+};
+
+
+namespace fixed_point_detail
+{
+    /*
+     * Upper bound on the number of characters produced when formatting a
+     * single FixedPoint number in any of the text formats, separator included.
+     * The longest one is a decimal Q(32,32) number, which needs a sign, 11
+     * integer digits, a decimal point and 32 fractional digits.
+     */
+    constexpr std::size_t MAX_TEXT_CHARS = 64;
+
+    /*
+     * Write unsigned integer 'n' in decimal form to 'p'. Returns a pointer to
+     * one past the last character written.
+     */
+    inline char *format_unsigned(char *p, unsigned long long n) noexcept
+    {
+        char tmp[20];
+        int len = 0;
+        do
+        {
+            tmp[len++] = static_cast<char>('0' + n % 10);
+            n /= 10;
+        } while (n);
+        while (len)
+            *p++ = tmp[--len];
+        return p;
+    }
+
+    /*
+     * Write the exact decimal expansion of raw FixedPoint number 'raw', with
+     * 'frac_bits' fractional bits, to 'p'. Returns a pointer to one past the
+     * last character written.
+     */
+    inline char *format_decimal(char *p, long long raw, int frac_bits) noexcept
+    {
+        /*
+         * Every binary fraction has a finite decimal expansion, with at most
+         * frac_bits digits. Generate them by repeatedly multiplying the
+         * fraction with ten, it never exceeds 36 bits.
+         */
+        using uns_ll = unsigned long long;
+        const uns_ll frac_mask = (1ull << frac_bits) - 1;
+        uns_ll mag = static_cast<uns_ll>(raw);
+        if (raw < 0)
+        {
+            *p++ = '-';
+            mag = 0ull - mag;
+        }
+        p = format_unsigned(p, mag >> frac_bits);
+        uns_ll frac = mag & frac_mask;
+        if (frac)
+        {
+            *p++ = '.';
+            do
+            {
+                frac *= 10;
+                *p++ = static_cast<char>('0' + (frac >> frac_bits));
+                frac &= frac_mask;
+            } while (frac);
+        }
+        return p;
+    }
+
+    /*
+     * Write a single FixedPoint number in text format 'fmt' to 'p'. Returns a
+     * pointer to one past the last character written. No allocations are
+     * performed.
+     */
+    template <int INT_BITS, int FRAC_BITS>
+    char *format_text(char *p, const FixedPoint<INT_BITS, FRAC_BITS> &fix,
+                      FixedPointTextFormat fmt) noexcept
+    {
+        static_assert(FRAC_BITS >= 0,
+                "Formatted numbers cannot have negative fractional bits.");
+        using uns_ll = unsigned long long;
+        const uns_ll frac_mask = (1ull << FRAC_BITS) - 1;
+        const long long raw = fix.get_raw();
+        switch (fmt)
+        {
+            case FixedPointTextFormat::decimal:
+                return format_decimal(p, raw, FRAC_BITS);
+            case FixedPointTextFormat::raw_hex:
+            {
+                constexpr int BITS = INT_BITS + FRAC_BITS;
+                constexpr int DIGITS = (BITS + 3) / 4;
+                uns_ll bits = static_cast<uns_ll>(raw);
+                if (BITS < 64)
+                    bits &= (1ull << (BITS % 64)) - 1;
+                *p++ = '0';
+                *p++ = 'x';
+                for (int i=DIGITS-1; i>=0; --i)
+                    *p++ = "0123456789abcdef"[(bits >> (4*i)) & 0xF];
+                return p;
+            }
+            case FixedPointTextFormat::quotient:
+            default:
+            {
+                long long int_part = raw >> FRAC_BITS;
+                if (int_part < 0)
+                {
+                    *p++ = '-';
+                    p = format_unsigned(
+                            p, 0ull - static_cast<uns_ll>(int_part));
+                }
+                else
+                {
+                    p = format_unsigned(p, static_cast<uns_ll>(int_part));
+                }
+                *p++ = ' '; *p++ = '+'; *p++ = ' ';
+                p = format_unsigned(p, static_cast<uns_ll>(raw) & frac_mask);
+                *p++ = '/';
+                return format_unsigned(p, 1ull << FRAC_BITS);
+            }
+        }
+    }
+}
+
+
+/*
+ * Buffered text writer for long sequences of FixedPoint numbers. Numbers are
+ * formatted into large in-memory chunks which are written to the output stream
+ * in one go. Values are separated by 'separator' and a newline is inserted
+ * after every 'columns' values, which makes it suitable for CSV output.
+ *
+ * With 'threads' > 1, long sequences are split into chunks of 'chunk_values'
+ * numbers which are formatted in parallel, by a FixedPointThreadPool started
+ * with the writer, and then written to the stream in order. The output is
+ * identical for any number of threads.
+ *
+ * Formatting does not allocate memory; all buffers are allocated once, when
+ * the writer is constructed. Remaining buffered output is written to the
+ * stream on flush() and on destruction. Errors of the stream, e.g, with
+ * exceptions enabled, are ignored by the destructor, so call flush() first
+ * to see them.
+ */
+class FixedPointTextWriter
+{
+public:
+    explicit FixedPointTextWriter(
+            std::ostream &os,
+            FixedPointTextFormat format=FixedPointTextFormat::decimal,
+            unsigned columns=1,
+            char separator=',',
+            unsigned threads=1,
+            std::size_t chunk_values=(1 << 16))
+        : os(os), format(format), columns(columns ? columns : 1),
+          separator(separator), threads(threads ? threads : 1),
+          chunk_values(chunk_values ? chunk_values : 1),
+          buffers(this->threads,
+                  std::vector<char>(
+                      this->chunk_values * fixed_point_detail::MAX_TEXT_CHARS)),
+          lengths(this->threads), fill{}, count{}, pool(this->threads)
+    {
+    }
+
+    FixedPointTextWriter(const FixedPointTextWriter &) = delete;
+    FixedPointTextWriter &operator=(const FixedPointTextWriter &) = delete;
+
+    ~FixedPointTextWriter()
+    {
+        try
+        {
+            this->flush();
+        }
+        catch (...)
+        {
+        }
+    }
+
+    /*
+     * Write 'n' FixedPoint numbers starting at 'data'.
+     */
+    template <int INT_BITS, int FRAC_BITS>
+    void write(const FixedPoint<INT_BITS, FRAC_BITS> *data, std::size_t n)
+    {
+        static_assert(FRAC_BITS >= 0,
+                "Formatted numbers cannot have negative fractional bits.");
+
+        /*
+         * Parallel path. Only worth it when there is at least one chunk per
+         * thread to format.
+         */
+        if (this->threads > 1 && n >= this->threads * this->chunk_values)
+        {
+            this->flush();
+            while (n >= this->chunk_values)
+            {
+                std::size_t chunks = std::min<std::size_t>(
+                        n / this->chunk_values, this->threads);
+                this->pool.run(chunks, [this, data](std::size_t t)
+                {
+                    this->lengths[t] = this->format_chunk(
+                            this->buffers[t].data(),
+                            data + t*this->chunk_values,
+                            this->chunk_values,
+                            this->count + t*this->chunk_values);
+                });
+
+                // Write the formatted chunks in order.
+                for (std::size_t t=0; t<chunks; ++t)
+                {
+                    this->os.write(
+                            this->buffers[t].data(),
+                            static_cast<std::streamsize>(this->lengths[t]));
+                }
+                data += chunks * this->chunk_values;
+                n -= chunks * this->chunk_values;
+                this->count += chunks * this->chunk_values;
+            }
+        }
+
+        /*
+         * Sequential path, also used for the remainder of the parallel path.
+         */
+        while (n)
+        {
+            std::size_t len = std::min(n, this->chunk_values);
+            std::size_t capacity = this->buffers[0].size();
+            if (this->fill + len*fixed_point_detail::MAX_TEXT_CHARS > capacity)
+                this->flush();
+            this->fill += this->format_chunk(
+                    this->buffers[0].data() + this->fill, data, len,
+                    this->count);
+            data += len;
+            n -= len;
+            this->count += len;
+        }
+    }
+
+    /*
+     * Write a single FixedPoint number.
+     */
+    template <int INT_BITS, int FRAC_BITS>
+    void write(const FixedPoint<INT_BITS, FRAC_BITS> &fix)
+    {
+        this->write(&fix, 1);
+    }
+
+    /*
+     * Write all buffered output to the stream.
+     */
+    void flush()
+    {
+        if (this->fill)
+        {
+            this->os.write(this->buffers[0].data(),
+                           static_cast<std::streamsize>(this->fill));
+            this->fill = 0;
+        }
+        this->os.flush();
+    }
+
+private:
+    /*
+     * Format 'n' numbers to 'p', where the first number has global index
+     * 'index' in the output sequence. Returns the number of characters
+     * written.
+     */
+    template <int INT_BITS, int FRAC_BITS>
+    std::size_t format_chunk(char *p,
+                             const FixedPoint<INT_BITS, FRAC_BITS> *data,
+                             std::size_t n, std::size_t index) const noexcept
+    {
+        char *begin = p;
+        std::size_t column = index % this->columns;
+        for (std::size_t i=0; i<n; ++i)
+        {
+            p = fixed_point_detail::format_text(p, data[i], this->format);
+            if (++column == this->columns)
+            {
+                *p++ = '\n';
+                column = 0;
+            }
+            else
+            {
+                *p++ = this->separator;
+            }
+        }
+        return static_cast<std::size_t>(p - begin);
+    }
+
+    std::ostream &os;
+    const FixedPointTextFormat format;
+    const unsigned columns;
+    const char separator;
+    const unsigned threads;
+    const std::size_t chunk_values;
+    std::vector<std::vector<char>> buffers;
+    std::vector<std::size_t> lengths;
+    std::size_t fill;
+    std::size_t count;
+    FixedPointThreadPool pool;
+};
+
+/*
+ * Bit-packed binary serialization of FixedPoint numbers. Each number is
+ * stored using exactly INT_BITS+FRAC_BITS bits, in two's complement. Numbers
+ * are packed LSb first into a little-endian byte stream, i.e, the first number
+ * occupies the least significant bits of the first byte(s), independent of the
+ * endianness of the host.
+ *
+ * A serialized stream starts with a 16 byte header:
+ *
+ *   Offset  Size  Content
+ *        0     4  Magic "PMFB".
+ *        4     1  Format version, currently 1.
+ *        5     1  Flags, currently 0 (LSb first, little-endian).
+ *        6     1  INT_BITS  (signed).
+ *        7     1  FRAC_BITS (signed).
+ *        8     8  Number of values, little-endian unsigned.
+ *
+ * followed by packed_size<INT_BITS, FRAC_BITS>(count) bytes of packed data.
+ */
+namespace fixed_point_detail
+{
+    constexpr unsigned char BINARY_MAGIC[4] = { 'P', 'M', 'F', 'B' };
+    constexpr unsigned char BINARY_VERSION = 1;
+    constexpr std::size_t BINARY_HEADER_SIZE = 16;
+
+    /*
+     * Number of values packed per chunk when streaming. A multiple of eight
+     * values always ends on a byte boundary.
+     */
+    constexpr std::size_t BINARY_CHUNK_VALUES = 8 * 4096;
+
+    __extension__ typedef unsigned __int128 uns_128;
+
+    inline void store_le64(unsigned char *p, unsigned long long v) noexcept
+    {
+        for (int i=0; i<8; ++i)
+            p[i] = static_cast<unsigned char>(v >> (8*i));
+    }
+
+    inline unsigned long long load_le64(const unsigned char *p) noexcept
+    {
+        unsigned long long v{};
+        for (int i=0; i<8; ++i)
+            v |= static_cast<unsigned long long>(p[i]) << (8*i);
+        return v;
+    }
+}
+
+/*
+ * Number of bytes needed to bit-pack 'n' FixedPoint<INT_BITS, FRAC_BITS>
+ * numbers, header excluded.
+ */
+template <int INT_BITS, int FRAC_BITS>
+constexpr std::size_t packed_size(std::size_t n) noexcept
+{
+    return (n * (INT_BITS+FRAC_BITS) + 7) / 8;
+}
+
+/*
+ * Bit-pack 'n' FixedPoint numbers from 'data' into 'out', which must have room
+ * for at least packed_size<INT_BITS, FRAC_BITS>(n) bytes.
+ *
+ * Bits are collected in a 128-bit accumulator and written out 64 bits at a
+ * time. The byte-wise stores and loads are merged into single word accesses by
+ * GCC and CLANG on little-endian hosts.
+ */
+template <int INT_BITS, int FRAC_BITS>
+void pack_bits(const FixedPoint<INT_BITS, FRAC_BITS> *data, std::size_t n,
+               unsigned char *out) noexcept
+{
+    constexpr int WIDTH = INT_BITS + FRAC_BITS;
+    constexpr unsigned long long MASK =
+        WIDTH < 64 ? (1ull << (WIDTH % 64)) - 1 : ~0ull;
+    fixed_point_detail::uns_128 acc{};
+    int acc_bits{};
+    for (std::size_t i=0; i<n; ++i)
+    {
+        unsigned long long bits = static_cast<unsigned long long>(
+                data[i].get_raw()) & MASK;
+        acc |= static_cast<fixed_point_detail::uns_128>(bits) << acc_bits;
+        acc_bits += WIDTH;
+        if (acc_bits >= 64)
+        {
+            fixed_point_detail::store_le64(
+                    out, static_cast<unsigned long long>(acc));
+            out += 8;
+            acc >>= 64;
+            acc_bits -= 64;
+        }
+    }
+
+    // Flush remaining bits.
+    for (; acc_bits > 0; acc_bits -= 8)
+    {
+        *out++ = static_cast<unsigned char>(acc);
+        acc >>= 8;
+    }
+}
+
+/*
+ * Unpack 'n' FixedPoint numbers from bit-packed data 'in', holding exactly
+ * packed_size<INT_BITS, FRAC_BITS>(n) bytes, into 'out'.
+ */
+template <int INT_BITS, int FRAC_BITS>
+void unpack_bits(const unsigned char *in, std::size_t n,
+                 FixedPoint<INT_BITS, FRAC_BITS> *out) noexcept
+{
+    constexpr int WIDTH = INT_BITS + FRAC_BITS;
+    constexpr unsigned long long MASK =
+        WIDTH < 64 ? (1ull << (WIDTH % 64)) - 1 : ~0ull;
+    const unsigned char *end = in + packed_size<INT_BITS, FRAC_BITS>(n);
+    fixed_point_detail::uns_128 acc{};
+    int acc_bits{};
+    for (std::size_t i=0; i<n; ++i)
+    {
+        // Refill the accumulator, a whole word at a time when possible.
+        if (acc_bits < WIDTH)
+        {
+            if (end - in >= 8)
+            {
+                acc |= static_cast<fixed_point_detail::uns_128>(
+                        fixed_point_detail::load_le64(in)) << acc_bits;
+                in += 8;
+                acc_bits += 64;
+            }
+            else
+            {
+                for (; in != end; acc_bits += 8)
+                {
+                    acc |= static_cast<fixed_point_detail::uns_128>(*in++)
+                        << acc_bits;
+                }
+            }
+        }
+
+        // Extract and sign extend.
+        unsigned long long bits = static_cast<unsigned long long>(acc) & MASK;
+        acc >>= WIDTH;
+        acc_bits -= WIDTH;
+        long long raw =
+            static_cast<long long>(bits << (64-WIDTH)) >> (64-WIDTH);
+        out[i].set_raw(raw);
+    }
+}
+
+/*
+ * Serialize 'n' FixedPoint numbers, header included, to a binary stream.
+ */
+template <int INT_BITS, int FRAC_BITS>
+void write_binary(std::ostream &os,
+                  const FixedPoint<INT_BITS, FRAC_BITS> *data, std::size_t n)
+{
+    using namespace fixed_point_detail;
+    unsigned char header[BINARY_HEADER_SIZE]{};
+    std::copy(BINARY_MAGIC, BINARY_MAGIC+4, header);
+    header[4] = BINARY_VERSION;
+    header[5] = 0;
+    header[6] = static_cast<unsigned char>(static_cast<signed char>(INT_BITS));
+    header[7] = static_cast<unsigned char>(static_cast<signed char>(FRAC_BITS));
+    store_le64(header+8, n);
+    os.write(reinterpret_cast<const char *>(header), BINARY_HEADER_SIZE);
+
+    // Pack and write the payload chunk by chunk.
+    std::vector<unsigned char> buffer(
+            packed_size<INT_BITS, FRAC_BITS>(BINARY_CHUNK_VALUES));
+    while (n)
+    {
+        std::size_t len = std::min(n, BINARY_CHUNK_VALUES);
+        pack_bits(data, len, buffer.data());
+        os.write(reinterpret_cast<const char *>(buffer.data()),
+                 static_cast<std::streamsize>(
+                     packed_size<INT_BITS, FRAC_BITS>(len)));
+        data += len;
+        n -= len;
+    }
+}
+
+/*
+ * Deserialize FixedPoint numbers from a binary stream written by
+ * write_binary(). A std::runtime_error is thrown if the stream is malformed or
+ * if the Q-format of the stream differs from that of the template arguments.
+ */
+template <int INT_BITS, int FRAC_BITS>
+std::vector<FixedPoint<INT_BITS, FRAC_BITS>> read_binary(std::istream &is)
+{
+    using namespace fixed_point_detail;
+    unsigned char header[BINARY_HEADER_SIZE]{};
+    if (!is.read(reinterpret_cast<char *>(header), BINARY_HEADER_SIZE))
+        throw std::runtime_error("PoorMansFixedPoint: truncated header.");
+    if (!std::equal(BINARY_MAGIC, BINARY_MAGIC+4, header))
+        throw std::runtime_error("PoorMansFixedPoint: bad magic number.");
+    if (header[4] != BINARY_VERSION || header[5] != 0)
+        throw std::runtime_error("PoorMansFixedPoint: unsupported version.");
+    if (static_cast<signed char>(header[6]) != INT_BITS ||
+        static_cast<signed char>(header[7]) != FRAC_BITS)
+    {
+        throw std::runtime_error("PoorMansFixedPoint: Q-format mismatch.");
+    }
+    std::size_t n = static_cast<std::size_t>(load_le64(header+8));
+
+    // Read and unpack the payload chunk by chunk.
+    std::vector<FixedPoint<INT_BITS, FRAC_BITS>> res{};
+    std::vector<unsigned char> buffer(
+            packed_size<INT_BITS, FRAC_BITS>(BINARY_CHUNK_VALUES));
+    while (res.size() < n)
+    {
+        std::size_t len = std::min(n - res.size(), BINARY_CHUNK_VALUES);
+        std::size_t bytes = packed_size<INT_BITS, FRAC_BITS>(len);
+        if (!is.read(reinterpret_cast<char *>(buffer.data()),
+                     static_cast<std::streamsize>(bytes)))
+        {
+            throw std::runtime_error("PoorMansFixedPoint: truncated data.");
+        }
+        res.resize(res.size() + len);
+        unpack_bits(buffer.data(), len, res.data() + res.size() - len);
+    }
+    return res;
+}
+
+
+/*
+ * Memory mappable FixedPoint sample files. Samples are stored as raw integers
+ * (see FixedPoint::get_raw()) in the narrowest signed integer type that holds
+ * INT_BITS+FRAC_BITS bits, in little-endian byte order. The samples start at
+ * byte offset 64 so that they are suitably aligned when the file is mapped.
+ *
+ *   Offset  Size  Content
+ *        0     4  Magic "PMFM".
+ *        4     1  Format version, currently 1.
+ *        5     1  Storage integer size in bytes (1, 2, 4 or 8).
+ *        6     1  INT_BITS  (signed).
+ *        7     1  FRAC_BITS (signed).
+ *        8     8  Number of samples, little-endian unsigned.
+ *       16    48  Reserved, zero.
+ *       64     -  Samples.
+ */
+namespace fixed_point_detail
+{
+    constexpr unsigned char MAPPED_MAGIC[4] = { 'P', 'M', 'F', 'M' };
+    constexpr unsigned char MAPPED_VERSION = 1;
+    constexpr std::size_t MAPPED_HEADER_SIZE = 64;
+    constexpr std::size_t MAPPED_CHUNK_VALUES = 4096;
+
+    /*
+     * Write 'n' raw FixedPoint numbers, retrieved through 'get_raw(i)', as
+     * little-endian integers of type 'storage_t'. Numbers are converted and
+     * written chunk by chunk.
+     */
+    template <typename storage_t, typename RawGetter>
+    void write_raw_le(std::ostream &os, RawGetter get_raw, std::size_t n)
+    {
+        unsigned char buffer[MAPPED_CHUNK_VALUES * sizeof(storage_t)];
+        for (std::size_t first=0; first<n; first+=MAPPED_CHUNK_VALUES)
+        {
+            std::size_t len = std::min(n - first, MAPPED_CHUNK_VALUES);
+            for (std::size_t i=0; i<len; ++i)
+            {
+                unsigned long long raw =
+                    static_cast<unsigned long long>(get_raw(first + i));
+                for (std::size_t b=0; b<sizeof(storage_t); ++b)
+                {
+                    buffer[i*sizeof(storage_t) + b] =
+                        static_cast<unsigned char>(raw >> (8*b));
+                }
+            }
+            os.write(reinterpret_cast<const char *>(buffer),
+                     static_cast<std::streamsize>(len * sizeof(storage_t)));
+        }
+    }
+}
+
+/*
+ * Write 'n' FixedPoint numbers, header included, to a memory mappable sample
+ * file stream. The stream should be opened in binary mode.
+ */
+template <int INT_BITS, int FRAC_BITS>
+void write_sample_file(std::ostream &os,
+                       const FixedPoint<INT_BITS, FRAC_BITS> *data,
+                       std::size_t n)
+{
+    using namespace fixed_point_detail;
+    using storage_t = typename storage_int<INT_BITS+FRAC_BITS>::type;
+    unsigned char header[MAPPED_HEADER_SIZE]{};
+    std::copy(MAPPED_MAGIC, MAPPED_MAGIC+4, header);
+    header[4] = MAPPED_VERSION;
+    header[5] = sizeof(storage_t);
+    header[6] = static_cast<unsigned char>(static_cast<signed char>(INT_BITS));
+    header[7] = static_cast<unsigned char>(static_cast<signed char>(FRAC_BITS));
+    store_le64(header+8, n);
+    os.write(reinterpret_cast<const char *>(header), MAPPED_HEADER_SIZE);
+    write_raw_le<storage_t>(
+            os, [data](std::size_t i) { return data[i].get_raw(); }, n);
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+namespace fixed_point_detail
+{
+    /*
+     * Read-only memory mapping of an entire file. The file is mapped on
+     * construction and unmapped on destruction. Throws std::runtime_error on
+     * failure.
+     */
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string &path)
+            : map{ nullptr }, map_size{}
+        {
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0)
+            {
+                throw std::runtime_error(
+                        "PoorMansFixedPoint: cannot open file.");
+            }
+            struct stat st{};
+            if (::fstat(fd, &st) != 0 || st.st_size == 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("PoorMansFixedPoint: empty file.");
+            }
+            this->map_size = static_cast<std::size_t>(st.st_size);
+            this->map = ::mmap(nullptr, this->map_size, PROT_READ, MAP_SHARED,
+                               fd, 0);
+            ::close(fd);
+            if (this->map == MAP_FAILED)
+            {
+                this->map = nullptr;
+                throw std::runtime_error(
+                        "PoorMansFixedPoint: cannot map file.");
+            }
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile()
+        {
+            ::munmap(this->map, this->map_size);
+        }
+
+        const unsigned char *data() const noexcept
+        {
+            return static_cast<const unsigned char *>(this->map);
+        }
+        std::size_t size() const noexcept { return this->map_size; }
+
+        /*
+         * Hint the kernel that the file will be read sequentially.
+         */
+        void advise_sequential() const noexcept
+        {
+            ::madvise(this->map, this->map_size, MADV_SEQUENTIAL);
+        }
+
+    private:
+        void *map;
+        std::size_t map_size;
+    };
+}
+
+/*
+ * Read-only, zero-copy view of a memory mapped FixedPoint sample file. The file
+ * is mapped on construction and unmapped on destruction. The header is
+ * validated against the template arguments on construction, and a
+ * std::runtime_error is thrown on mismatch or I/O failure.
+ *
+ * Samples are never parsed nor copied up front, each access reads the raw
+ * integer straight from the mapping.
+ */
+template <int INT_BITS, int FRAC_BITS>
+class FixedPointSampleFile
+{
+public:
+    using storage_t =
+        typename fixed_point_detail::storage_int<INT_BITS+FRAC_BITS>::type;
+
+    explicit FixedPointSampleFile(const std::string &path)
+        : file{ path }, samples{ nullptr }, count{}
+    {
+        using namespace fixed_point_detail;
+        static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+                "PoorMansFixedPoint: sample files require little-endian host.");
+
+        const unsigned char *header = this->file.data();
+        if (this->file.size() < MAPPED_HEADER_SIZE)
+            throw std::runtime_error("PoorMansFixedPoint: truncated header.");
+        if (!std::equal(MAPPED_MAGIC, MAPPED_MAGIC+4, header))
+            throw std::runtime_error("PoorMansFixedPoint: bad magic number.");
+        if (header[4] != MAPPED_VERSION)
+        {
+            throw std::runtime_error(
+                    "PoorMansFixedPoint: unsupported version.");
+        }
+        if (header[5] != sizeof(storage_t) ||
+            static_cast<signed char>(header[6]) != INT_BITS ||
+            static_cast<signed char>(header[7]) != FRAC_BITS)
+        {
+            throw std::runtime_error("PoorMansFixedPoint: Q-format mismatch.");
+        }
+        this->count = static_cast<std::size_t>(load_le64(header+8));
+        if ((this->file.size() - MAPPED_HEADER_SIZE) / sizeof(storage_t)
+                < this->count)
+        {
+            throw std::runtime_error("PoorMansFixedPoint: truncated data.");
+        }
+        this->samples = reinterpret_cast<const storage_t *>(
+                header + MAPPED_HEADER_SIZE);
+    }
+
+    FixedPointSampleFile(const FixedPointSampleFile &) = delete;
+    FixedPointSampleFile &operator=(const FixedPointSampleFile &) = delete;
+
+    /*
+     * Number of samples in the file.
+     */
+    std::size_t size() const noexcept { return this->count; }
+
+    /*
+     * Raw integer samples, straight from the mapping.
+     */
+    const storage_t *raw_data() const noexcept { return this->samples; }
+
+    /*
+     * Retrieve sample 'i' as a FixedPoint number.
+     */
+    FixedPoint<INT_BITS, FRAC_BITS> operator[](std::size_t i) const noexcept
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        res.set_raw(this->samples[i]);
+        return res;
+    }
+
+    /*
+     * View of all samples in the file.
+     */
+    FixedPointSpan<INT_BITS, FRAC_BITS, const storage_t> span() const noexcept
+    {
+        return { this->samples, this->count };
+    }
+
+    /*
+     * Hint the kernel that the samples will be read sequentially.
+     */
+    void advise_sequential() const noexcept
+    {
+        this->file.advise_sequential();
+    }
+
+private:
+    fixed_point_detail::MappedFile file;
+    const storage_t *samples;
+    std::size_t count;
+};
+
+#endif
+
+/*
+ * NumPy .npy files of FixedPoint numbers. Numbers are stored as raw integers
+ * (see FixedPoint::get_raw()) in the narrowest little-endian signed integer
+ * dtype that holds INT_BITS+FRAC_BITS bits, so that NumPy loads them as plain
+ * integer arrays. The real value of an element is raw / 2**FRAC_BITS.
+ *
+ * The Q-format is recorded as a trailing comment of the header dictionary,
+ * e.g, "# PoorMansFixedPoint Q(3,9)", which is ignored by NumPy. When reading,
+ * the Q-format is validated against the template arguments if present, and
+ * files without it (e.g, written by NumPy) are accepted as long as the dtype
+ * matches.
+ */
+namespace fixed_point_detail
+{
+    constexpr char NPY_MAGIC[6] = { '\x93', 'N', 'U', 'M', 'P', 'Y' };
+    constexpr char NPY_Q_TAG[] = "# PoorMansFixedPoint Q(";
+
+    /*
+     * NumPy dtype string of a little-endian signed integer type.
+     */
+    template <typename storage_t>
+    std::string npy_descr()
+    {
+        return (sizeof(storage_t) == 1 ? "'|i" : "'<i")
+            + std::to_string(sizeof(storage_t)) + "'";
+    }
+
+    /*
+     * Write a version 1.0 .npy header for 'n' elements of type 'storage_t'.
+     * The header is padded so that the data starts at a 64 byte boundary.
+     */
+    template <typename storage_t>
+    void write_npy_header(std::ostream &os, int int_bits, int frac_bits,
+                          std::size_t n)
+    {
+        std::string dict = "{'descr': " + npy_descr<storage_t>()
+            + ", 'fortran_order': False, 'shape': (" + std::to_string(n)
+            + ",), } " + NPY_Q_TAG + std::to_string(int_bits) + ","
+            + std::to_string(frac_bits) + ")";
+        std::size_t total = sizeof(NPY_MAGIC) + 4 + dict.size() + 1;
+        dict.append((64 - total % 64) % 64, ' ');
+        dict.push_back('\n');
+
+        unsigned char preamble[4] = {
+            1, 0,
+            static_cast<unsigned char>(dict.size()),
+            static_cast<unsigned char>(dict.size() >> 8)
+        };
+        os.write(NPY_MAGIC, sizeof(NPY_MAGIC));
+        os.write(reinterpret_cast<const char *>(preamble), 4);
+        os.write(dict.data(), static_cast<std::streamsize>(dict.size()));
+    }
+
+    /*
+     * Parsed content of a .npy header.
+     */
+    struct NpyHeader
+    {
+        std::size_t data_offset;
+        std::string descr;
+        bool fortran_order;
+        std::size_t count;
+        bool has_q_format;
+        int int_bits;
+        int frac_bits;
+    };
+
+    /*
+     * Parse the header of the .npy file in 'data' of 'size' bytes. Only the
+     * subset of the format written by NumPy for plain arrays is supported.
+     * Throws std::runtime_error if the header is malformed.
+     */
+    inline NpyHeader parse_npy_header(const unsigned char *data,
+                                      std::size_t size)
+    {
+        const std::runtime_error malformed{
+            "PoorMansFixedPoint: malformed .npy header." };
+        if (size < 10 || !std::equal(NPY_MAGIC, NPY_MAGIC+6,
+                                     reinterpret_cast<const char *>(data)))
+        {
+            throw malformed;
+        }
+
+        // Version 1.0 has a 2 byte header length, version 2.0 and 3.0 use 4.
+        std::size_t header_len{}, offset{};
+        if (data[6] == 1)
+        {
+            header_len = data[8] | (std::size_t{ data[9] } << 8);
+            offset = 10;
+        }
+        else if ((data[6] == 2 || data[6] == 3) && size >= 12)
+        {
+            header_len = data[8] | (std::size_t{ data[9] } << 8)
+                | (std::size_t{ data[10] } << 16)
+                | (std::size_t{ data[11] } << 24);
+            offset = 12;
+        }
+        else
+        {
+            throw malformed;
+        }
+        if (size - offset < header_len)
+            throw malformed;
+        const std::string dict{
+            reinterpret_cast<const char *>(data) + offset, header_len };
+
+        NpyHeader header{ offset + header_len, {}, false, 1, false, 0, 0 };
+
+        // 'descr': quoted dtype string.
+        std::size_t pos = dict.find("'descr':");
+        if (pos == std::string::npos)
+            throw malformed;
+        std::size_t begin = dict.find('\'', pos + 8);
+        if (begin == std::string::npos)
+            throw malformed;
+        std::size_t end = dict.find('\'', begin + 1);
+        if (end == std::string::npos)
+            throw malformed;
+        header.descr = dict.substr(begin, end - begin + 1);
+
+        // 'fortran_order': True or False.
+        pos = dict.find("'fortran_order':");
+        if (pos == std::string::npos)
+            throw malformed;
+        pos = dict.find_first_not_of(' ', pos + 16);
+        if (pos == std::string::npos)
+            throw malformed;
+        header.fortran_order = dict.compare(pos, 4, "True") == 0;
+
+        // 'shape': tuple of dimensions, the number of elements is its product.
+        // A product that overflows std::size_t is rejected, such that the
+        // count can be checked against the size of the file.
+        pos = dict.find("'shape':");
+        if (pos == std::string::npos)
+            throw malformed;
+        begin = dict.find('(', pos);
+        if (begin == std::string::npos)
+            throw malformed;
+        end = dict.find(')', begin);
+        if (end == std::string::npos)
+            throw malformed;
+        for (std::size_t i=begin+1; i<end; )
+        {
+            if (std::isdigit(static_cast<unsigned char>(dict[i])))
+            {
+                const char *first{ dict.c_str() + i };
+                char *last{};
+                errno = 0;
+                unsigned long long dim{ std::strtoull(first, &last, 10) };
+                if (errno == ERANGE || dim > SIZE_MAX ||
+                    (dim != 0 && header.count > SIZE_MAX / dim))
+                {
+                    throw malformed;
+                }
+                header.count *= static_cast<std::size_t>(dim);
+                i += static_cast<std::size_t>(last - first);
+            }
+            else
+            {
+                ++i;
+            }
+        }
+
+        // Optional Q-format tag, "Q(INT_BITS,FRAC_BITS)".
+        pos = dict.find(NPY_Q_TAG);
+        if (pos != std::string::npos)
+        {
+            auto parse_int = [&dict, &malformed](std::size_t &at, char sep)
+            {
+                const char *first{ dict.c_str() + at };
+                char *last{};
+                errno = 0;
+                long value{ std::strtol(first, &last, 10) };
+                if (last == first || *last != sep || errno == ERANGE ||
+                    value < INT_MIN || value > INT_MAX)
+                {
+                    throw malformed;
+                }
+                at += static_cast<std::size_t>(last - first) + 1;
+                return static_cast<int>(value);
+            };
+            pos += sizeof(NPY_Q_TAG) - 1;
+            header.int_bits = parse_int(pos, ',');
+            header.frac_bits = parse_int(pos, ')');
+            header.has_q_format = true;
+        }
+        return header;
+    }
+}
+
+/*
+ * Write 'n' FixedPoint numbers, header included, to a .npy stream. The stream
+ * should be opened in binary mode.
+ */
+template <int INT_BITS, int FRAC_BITS>
+void write_npy(std::ostream &os, const FixedPoint<INT_BITS, FRAC_BITS> *data,
+               std::size_t n)
+{
+    using namespace fixed_point_detail;
+    using storage_t = typename storage_int<INT_BITS+FRAC_BITS>::type;
+    write_npy_header<storage_t>(os, INT_BITS, FRAC_BITS, n);
+    write_raw_le<storage_t>(
+            os, [data](std::size_t i) { return data[i].get_raw(); }, n);
+}
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+void write_npy(std::ostream &os,
+               const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &span)
+{
+    using namespace fixed_point_detail;
+    using storage_t = typename storage_int<INT_BITS+FRAC_BITS>::type;
+    write_npy_header<storage_t>(os, INT_BITS, FRAC_BITS, span.size());
+    write_raw_le<storage_t>(
+            os, [&span](std::size_t i) { return span.get(i).get_raw(); },
+            span.size());
+}
+
+#if defined(__unix__) || defined(__APPLE__)
+
+/*
+ * Read-only, zero-copy view of a memory mapped .npy file of FixedPoint numbers.
+ * The file must hold a C-ordered array of little-endian integers of type
+ * StorageInt, and if the header carries a Q-format it must equal the template
+ * arguments. Multi-dimensional arrays are viewed flattened. A
+ * std::runtime_error is thrown on mismatch or I/O failure.
+ */
+template <
+    int INT_BITS, int FRAC_BITS,
+    typename StorageInt =
+        typename fixed_point_detail::storage_int<INT_BITS+FRAC_BITS>::type>
+class FixedPointNpyFile
+{
+public:
+    explicit FixedPointNpyFile(const std::string &path)
+        : file{ path }, samples{}
+    {
+        using namespace fixed_point_detail;
+        static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+                "PoorMansFixedPoint: .npy views require little-endian host.");
+
+        NpyHeader header = parse_npy_header(this->file.data(),
+                                            this->file.size());
+        if (header.descr != npy_descr<StorageInt>() || header.fortran_order)
+        {
+            throw std::runtime_error(
+                    "PoorMansFixedPoint: unsupported .npy dtype or order.");
+        }
+        if (header.has_q_format && (header.int_bits != INT_BITS ||
+                                    header.frac_bits != FRAC_BITS))
+        {
+            throw std::runtime_error("PoorMansFixedPoint: Q-format mismatch.");
+        }
+        if ((this->file.size() - header.data_offset) / sizeof(StorageInt)
+                < header.count)
+        {
+            throw std::runtime_error("PoorMansFixedPoint: truncated data.");
+        }
+        this->samples = FixedPointSpan<INT_BITS, FRAC_BITS, const StorageInt>{
+            reinterpret_cast<const StorageInt *>(
+                    this->file.data() + header.data_offset),
+            header.count };
+    }
+
+    /*
+     * Number of elements in the array.
+     */
+    std::size_t size() const noexcept { return this->samples.size(); }
+
+    /*
+     * Retrieve element 'i' as a FixedPoint number.
+     */
+    FixedPoint<INT_BITS, FRAC_BITS> operator[](std::size_t i) const noexcept
+    {
+        return this->samples.get(i);
+    }
+
+    /*
+     * View of all elements in the array.
+     */
+    FixedPointSpan<INT_BITS, FRAC_BITS, const StorageInt> span() const noexcept
+    {
+        return this->samples;
+    }
+
+    /*
+     * Hint the kernel that the elements will be read sequentially.
+     */
+    void advise_sequential() const noexcept
+    {
+        this->file.advise_sequential();
+    }
+
+private:
+    fixed_point_detail::MappedFile file;
+    FixedPointSpan<INT_BITS, FRAC_BITS, const StorageInt> samples;
+};
+
+/*
+ * Load an entire .npy file of FixedPoint numbers, see FixedPointNpyFile.
+ */
+template <int INT_BITS, int FRAC_BITS>
+std::vector<FixedPoint<INT_BITS, FRAC_BITS>> read_npy(const std::string &path)
+{
+    FixedPointNpyFile<INT_BITS, FRAC_BITS> file{ path };
+    file.advise_sequential();
+    std::vector<FixedPoint<INT_BITS, FRAC_BITS>> res(file.size());
+    for (std::size_t i=0; i<res.size(); ++i)
+        res[i] = file[i];
+    return res;
+}
+
+#endif
+
+
+/*
+ * Include guard end.
+ */
+#endif
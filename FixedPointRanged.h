@@ -0,0 +1,364 @@
+/*
+ * PoorMansFixedPoint compile-time range extension. A RangedFixedPoint number
+ * carries a value interval [LO, HI] as template arguments, and every
+ * arithmetic operation computes the interval of its result at compile time.
+ * Results are exact, see FixedPointExact.h, but instead of growing by the
+ * worst case of the operand formats, a result gets the narrowest format that
+ * provably holds its interval.
+ *
+ * The bounds are raw integers, that is, values scaled by 2^FRAC_BITS. Inputs
+ * get the full range of their format, or a narrower interval claimed by the
+ * user, e.g, a Q(1,15) input known to stay in [-0.5, 0.5]:
+ *
+ *     auto x = assume_fixed_point_range<-16384, 16384>(sample);
+ *     auto c = assume_fixed_point_range<9830, 9830>(FixedPoint<1,15>{ 0.3 });
+ *     auto y = x * c + x;
+ *     FixedPoint<1,15> out = y.saturate_to<1,15>();
+ *
+ * Here y is known to lie in [-0.65, 0.65], so the saturation is a plain
+ * rounding: the clamps are removed at compile time, and with them the min/max
+ * on every sample. A claimed interval is checked when compiling with
+ * '_DEBUG_SHOW_OVERFLOW_INFO' defined, see FixedPoint.h.
+ *
+ * Intervals must fit in 64-bit integers. An expression whose interval does
+ * not is rejected at compile time. As every operation widens the interval,
+ * loops should accumulate into an ExactFixedPoint or FixedPoint number.
+ *
+ * Everything in here is built on top of the public interface of FixedPoint.h,
+ * and the core header does not depend on this one.
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_RANGED_H
+#define _POOR_MANS_FIXED_POINT_RANGED_H
+
+#include "FixedPoint.h"
+#include "FixedPointExact.h"
+#include <cmath>
+#include <algorithm>
+
+#ifdef _DEBUG_SHOW_OVERFLOW_INFO
+    #include <sstream>
+#endif
+
+
+namespace fixed_point_detail
+{
+    /*
+     * Smallest number of bits of a two's complement integer which holds
+     * every integer in [lo, hi].
+     */
+    constexpr int range_bits(long long lo, long long hi) noexcept
+    {
+        int bits = 1;
+        while (bits < 64 && (lo < -(1ll << (bits-1)) ||
+                             hi > (1ll << (bits-1)) - 1))
+        {
+            ++bits;
+        }
+        return bits;
+    }
+
+    /*
+     * Interval bound 'x' multiplied by 2^n. Overflow is not a constant
+     * expression, which turns an unrepresentable interval into a compile
+     * error.
+     */
+    constexpr long long scale_bound(long long x, int n) noexcept
+    {
+        return x * (1ll << n);
+    }
+
+    /*
+     * Smallest and largest raw integer of BITS bits.
+     */
+    constexpr long long min_raw(int bits) noexcept
+    {
+        return bits > 1 ? -(1ll << (bits > 1 ? bits-2 : 0)) * 2 : -1;
+    }
+    constexpr long long max_raw(int bits) noexcept
+    {
+        return bits > 1 ? ((1ll << (bits > 1 ? bits-2 : 0)) - 1) * 2 + 1 : 0;
+    }
+
+    constexpr long long min_bound(long long a, long long b, long long c,
+                                  long long d) noexcept
+    {
+        return std::min(std::min(a, b), std::min(c, d));
+    }
+    constexpr long long max_bound(long long a, long long b, long long c,
+                                  long long d) noexcept
+    {
+        return std::max(std::max(a, b), std::max(c, d));
+    }
+}
+
+
+/*
+ * Type RangedFixedPoint begin.
+ */
+template <int FRAC_BITS, long long LO, long long HI>
+class RangedFixedPoint
+{
+    static_assert(LO <= HI, "RangedFixedPoint interval is empty.");
+
+    /*
+     * Number of bits of the narrowest format holding the interval.
+     */
+    static constexpr int BITS = fixed_point_detail::range_bits(LO, HI);
+
+public:
+    using value_type = ExactFixedPoint<BITS-FRAC_BITS, FRAC_BITS>;
+    using storage_type = typename value_type::storage_type;
+
+private:
+    /*
+     * The number scaled by 2^FRAC_BITS, always in [LO, HI].
+     */
+    storage_type raw{};
+
+    template <int _FRAC_BITS, long long _LO, long long _HI>
+    friend class RangedFixedPoint;
+
+    /*
+     * Create a number from a raw integer which is known to be in [LO, HI].
+     */
+    struct exact_tag {};
+    constexpr RangedFixedPoint(exact_tag, long long raw) noexcept
+        : raw{ static_cast<storage_type>(raw) } {}
+
+    /*
+     * The raw integer of this number scaled to ALIGN_FRAC_BITS >= FRAC_BITS
+     * fractional bits.
+     */
+    template <int ALIGN_FRAC_BITS>
+    constexpr long long aligned() const noexcept
+    {
+        return fixed_point_detail::scale_up<ALIGN_FRAC_BITS-FRAC_BITS>(
+                static_cast<long long>(this->raw));
+    }
+
+    /*
+     * Raw integer 'x', of this format, rounded to RES_FRAC_BITS fractional
+     * bits as an integer of type T. The result never overflows if T has
+     * room for BITS + max(RES_FRAC_BITS - FRAC_BITS, 0) bits.
+     */
+    template <int RES_FRAC_BITS, typename T>
+    static constexpr T rounded(long long x) noexcept
+    {
+        return fixed_point_detail::scale_up<
+            std::max(RES_FRAC_BITS - FRAC_BITS, 0)>(
+                fixed_point_detail::round_raw<FRAC_BITS, RES_FRAC_BITS>(
+                    static_cast<T>(x)));
+    }
+    template <int RES_FRAC_BITS>
+    using rounded_type = typename fixed_point_detail::exact_int<
+        BITS + std::max(RES_FRAC_BITS - FRAC_BITS, 0)>::work_type;
+
+public:
+    /*
+     * Initialization from a FixedPoint number with no more fractional bits,
+     * which the caller guarantees to lie in the interval. The guarantee is
+     * checked when '_DEBUG_SHOW_OVERFLOW_INFO' is defined.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    explicit RangedFixedPoint(
+            const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs) noexcept
+    {
+        static_assert(RHS_FRAC_BITS <= FRAC_BITS,
+                "Initialization from more fractional bits is not exact.");
+        long long rhs_raw = fixed_point_detail::scale_up<
+            FRAC_BITS-RHS_FRAC_BITS>(rhs.get_raw());
+
+    #ifdef _DEBUG_SHOW_OVERFLOW_INFO
+        if (rhs_raw < LO || rhs_raw > HI)
+        {
+            std::stringstream ss{};
+            ss << "Range violation in node [" << LO << "," << HI << "]/2^"
+               << FRAC_BITS << " of value: " << rhs.to_string();
+            _DEBUG_PRINT_FUNC(ss.str().c_str());
+        }
+    #endif
+        this->raw = static_cast<storage_type>(
+                fixed_point_detail::wrap_bits<BITS>(rhs_raw));
+    }
+
+    /*
+     * Get the format and the interval of the number.
+     */
+    constexpr int get_int_bits() const noexcept { return BITS-FRAC_BITS; }
+    constexpr int get_frac_bits() const noexcept { return FRAC_BITS; }
+    static constexpr long long lower_raw() noexcept { return LO; }
+    static constexpr long long upper_raw() noexcept { return HI; }
+    static double lower() noexcept { return std::ldexp(LO, -FRAC_BITS); }
+    static double upper() noexcept { return std::ldexp(HI, -FRAC_BITS); }
+
+    /*
+     * Test if every number of the interval fits, after rounding, into a
+     * FixedPoint<RES_INT_BITS, RES_FRAC_BITS> number.
+     */
+    template <int RES_INT_BITS, int RES_FRAC_BITS>
+    static constexpr bool fits_in() noexcept
+    {
+        using T = rounded_type<RES_FRAC_BITS>;
+        return rounded<RES_FRAC_BITS, T>(LO) >=
+                   fixed_point_detail::min_raw(RES_INT_BITS+RES_FRAC_BITS) &&
+               rounded<RES_FRAC_BITS, T>(HI) <=
+                   fixed_point_detail::max_raw(RES_INT_BITS+RES_FRAC_BITS);
+    }
+
+    /*
+     * The exact value and the raw integer of the number.
+     */
+    value_type value() const noexcept { return value_type::from_raw(raw); }
+    constexpr storage_type get_raw() const noexcept { return this->raw; }
+
+    explicit operator double() const noexcept
+    {
+        return std::ldexp(static_cast<double>(this->raw), -FRAC_BITS);
+    }
+
+    /*
+     * Narrow the number to a FixedPoint number with the rounding and wrap
+     * around semantics of ExactFixedPoint::round_to().
+     */
+    template <int RES_INT_BITS, int RES_FRAC_BITS>
+    FixedPoint<RES_INT_BITS, RES_FRAC_BITS> round_to() const noexcept
+    {
+        return this->value().template round_to<RES_INT_BITS, RES_FRAC_BITS>();
+    }
+
+    /*
+     * Narrow the number to a FixedPoint number, like round_to(), but saturate
+     * the result to the largest or smallest FixedPoint number on overflow.
+     * Clamps which the interval proves unnecessary are removed at compile
+     * time.
+     */
+    template <int RES_INT_BITS, int RES_FRAC_BITS>
+    FixedPoint<RES_INT_BITS, RES_FRAC_BITS> saturate_to() const noexcept
+    {
+        using T = rounded_type<RES_FRAC_BITS>;
+        constexpr T MIN{ fixed_point_detail::min_raw(
+                RES_INT_BITS+RES_FRAC_BITS) };
+        constexpr T MAX{ fixed_point_detail::max_raw(
+                RES_INT_BITS+RES_FRAC_BITS) };
+        constexpr bool CLAMP_LO = rounded<RES_FRAC_BITS, T>(LO) < MIN;
+        constexpr bool CLAMP_HI = rounded<RES_FRAC_BITS, T>(HI) > MAX;
+        T res_raw{ rounded<RES_FRAC_BITS, T>(this->raw) };
+        if (CLAMP_LO)
+            res_raw = std::max(res_raw, MIN);
+        if (CLAMP_HI)
+            res_raw = std::min(res_raw, MAX);
+
+        FixedPoint<RES_INT_BITS, RES_FRAC_BITS> res{};
+        res.set_raw(static_cast<long long>(res_raw));
+        return res;
+    }
+
+    /*
+     * Unary negation operator.
+     */
+    template <long long _LO = LO, long long _HI = HI>
+    constexpr RangedFixedPoint<FRAC_BITS, -_HI, -_LO> operator-()
+        const noexcept
+    {
+        using res_type = RangedFixedPoint<FRAC_BITS, -_HI, -_LO>;
+        return res_type{ typename res_type::exact_tag{},
+                         -static_cast<long long>(this->raw) };
+    }
+
+    /*
+     * Addition/subtraction of RangedFixedPoint numbers. The result has as many
+     * fractional bits as the operand with the most fractional bits.
+     */
+    template <int RHS_FRAC_BITS, long long RHS_LO, long long RHS_HI>
+    constexpr RangedFixedPoint<std::max(FRAC_BITS, RHS_FRAC_BITS),
+        fixed_point_detail::scale_bound(
+            LO, std::max(FRAC_BITS, RHS_FRAC_BITS) - FRAC_BITS) +
+        fixed_point_detail::scale_bound(
+            RHS_LO, std::max(FRAC_BITS, RHS_FRAC_BITS) - RHS_FRAC_BITS),
+        fixed_point_detail::scale_bound(
+            HI, std::max(FRAC_BITS, RHS_FRAC_BITS) - FRAC_BITS) +
+        fixed_point_detail::scale_bound(
+            RHS_HI, std::max(FRAC_BITS, RHS_FRAC_BITS) - RHS_FRAC_BITS)>
+        operator+(const RangedFixedPoint<RHS_FRAC_BITS, RHS_LO, RHS_HI> &rhs)
+        const noexcept
+    {
+        constexpr int RES_FRAC_BITS = std::max(FRAC_BITS, RHS_FRAC_BITS);
+        using res_type = decltype(*this + rhs);
+        return res_type{ typename res_type::exact_tag{},
+                         this->template aligned<RES_FRAC_BITS>() +
+                           rhs.template aligned<RES_FRAC_BITS>() };
+    }
+    template <int RHS_FRAC_BITS, long long RHS_LO, long long RHS_HI>
+    constexpr RangedFixedPoint<std::max(FRAC_BITS, RHS_FRAC_BITS),
+        fixed_point_detail::scale_bound(
+            LO, std::max(FRAC_BITS, RHS_FRAC_BITS) - FRAC_BITS) -
+        fixed_point_detail::scale_bound(
+            RHS_HI, std::max(FRAC_BITS, RHS_FRAC_BITS) - RHS_FRAC_BITS),
+        fixed_point_detail::scale_bound(
+            HI, std::max(FRAC_BITS, RHS_FRAC_BITS) - FRAC_BITS) -
+        fixed_point_detail::scale_bound(
+            RHS_LO, std::max(FRAC_BITS, RHS_FRAC_BITS) - RHS_FRAC_BITS)>
+        operator-(const RangedFixedPoint<RHS_FRAC_BITS, RHS_LO, RHS_HI> &rhs)
+        const noexcept
+    {
+        constexpr int RES_FRAC_BITS = std::max(FRAC_BITS, RHS_FRAC_BITS);
+        using res_type = decltype(*this - rhs);
+        return res_type{ typename res_type::exact_tag{},
+                         this->template aligned<RES_FRAC_BITS>() -
+                           rhs.template aligned<RES_FRAC_BITS>() };
+    }
+
+    /*
+     * Multiplication of RangedFixedPoint numbers. The result has the sum of
+     * the fractional bits of the operands.
+     */
+    template <int RHS_FRAC_BITS, long long RHS_LO, long long RHS_HI>
+    constexpr RangedFixedPoint<FRAC_BITS+RHS_FRAC_BITS,
+        fixed_point_detail::min_bound(LO*RHS_LO, LO*RHS_HI,
+                                      HI*RHS_LO, HI*RHS_HI),
+        fixed_point_detail::max_bound(LO*RHS_LO, LO*RHS_HI,
+                                      HI*RHS_LO, HI*RHS_HI)>
+        operator*(const RangedFixedPoint<RHS_FRAC_BITS, RHS_LO, RHS_HI> &rhs)
+        const noexcept
+    {
+        using res_type = decltype(*this * rhs);
+        return res_type{ typename res_type::exact_tag{},
+                         static_cast<long long>(this->raw) * rhs.raw };
+    }
+};
+
+
+/*
+ * Create a RangedFixedPoint number with the full range of a FixedPoint number.
+ */
+template <int INT_BITS, int FRAC_BITS>
+RangedFixedPoint<FRAC_BITS,
+                 fixed_point_detail::min_raw(INT_BITS+FRAC_BITS),
+                 fixed_point_detail::max_raw(INT_BITS+FRAC_BITS)>
+    make_ranged_fixed_point(const FixedPoint<INT_BITS, FRAC_BITS> &x) noexcept
+{
+    return RangedFixedPoint<FRAC_BITS,
+                            fixed_point_detail::min_raw(INT_BITS+FRAC_BITS),
+                            fixed_point_detail::max_raw(INT_BITS+FRAC_BITS)>{
+        x };
+}
+
+/*
+ * Create a RangedFixedPoint number with an interval [LO, HI], in raw integers
+ * of the FixedPoint format, which the caller guarantees 'x' to lie in. For
+ * constants, use LO = HI = x.get_raw().
+ */
+template <long long LO, long long HI, int INT_BITS, int FRAC_BITS>
+RangedFixedPoint<FRAC_BITS, LO, HI>
+    assume_fixed_point_range(const FixedPoint<INT_BITS, FRAC_BITS> &x) noexcept
+{
+    return RangedFixedPoint<FRAC_BITS, LO, HI>{ x };
+}
+
+/*
+ * Include guard end.
+ */
+#endif
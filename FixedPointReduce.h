@@ -0,0 +1,508 @@
+/*
+ * PoorMansFixedPoint parallel reduction extension. Sums, dot products,
+ * minima, maxima and means over FixedPointSpan views, computed by a thread
+ * pool and with vectorizable loops over the raw integers.
+ *
+ * Unlike floating point addition, addition of FixedPoint numbers with no more
+ * fractional bits than the accumulator never rounds, and two's complement wrap
+ * around is associative. The span is split into chunks of a fixed length,
+ * independent of the number of threads, and the partial results of the chunks
+ * are combined in order. Hence the results are bit-identical to those of the
+ * sequential loop, e.g,
+ *
+ *     FixedPoint<32,FRAC_BITS> acc{};
+ *     for (std::size_t i=0; i<x.size(); ++i)
+ *         acc += x.get(i);
+ *
+ * for any number of threads, including the overloads without a thread pool.
+ *
+ * Everything in here is built on top of the public interface of FixedPoint.h,
+ * and the core header does not depend on this one.
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_REDUCE_H
+#define _POOR_MANS_FIXED_POINT_REDUCE_H
+
+#include "FixedPoint.h"
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stdexcept>
+#include <algorithm>
+#include <limits>
+#include <cstddef>
+#include <type_traits>
+
+
+/*
+ * Pool of worker threads for the parallel reductions. A pool of size n has
+ * n-1 worker threads, as the thread calling run() takes part in the work.
+ */
+class FixedPointThreadPool
+{
+public:
+    explicit FixedPointThreadPool(
+            unsigned threads=std::thread::hardware_concurrency())
+    {
+        // If a thread cannot be started, the workers already started are
+        // joined before the std::system_error propagates.
+        try
+        {
+            for (unsigned t=1; t<threads; ++t)
+                this->workers.emplace_back([this] { this->work(); });
+        }
+        catch (...)
+        {
+            this->stop();
+            throw;
+        }
+    }
+
+    FixedPointThreadPool(const FixedPointThreadPool &) = delete;
+    FixedPointThreadPool &operator=(const FixedPointThreadPool &) = delete;
+
+    ~FixedPointThreadPool()
+    {
+        this->stop();
+    }
+
+    /*
+     * Number of threads, including the calling thread.
+     */
+    unsigned size() const noexcept
+    {
+        return static_cast<unsigned>(this->workers.size()) + 1;
+    }
+
+    /*
+     * Call task(i) for every i in [0, tasks), spread over the threads of the
+     * pool, and return when all calls have returned. Tasks must not throw,
+     * and only one thread at a time may call run() on a pool.
+     */
+    template <typename Task>
+    void run(std::size_t tasks, const Task &task)
+    {
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            this->job = [&task](std::size_t i) { task(i); };
+            this->job_tasks = tasks;
+            this->next_task = 0;
+            this->active = this->workers.size();
+            ++this->generation;
+        }
+        this->wake.notify_all();
+        this->drain();
+
+        std::unique_lock<std::mutex> lock{ this->mutex };
+        this->done.wait(lock, [this] { return this->active == 0; });
+        this->job = nullptr;
+    }
+
+private:
+    void stop() noexcept
+    {
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            this->stopping = true;
+        }
+        this->wake.notify_all();
+        for (std::thread &worker : this->workers)
+            worker.join();
+    }
+
+    void drain()
+    {
+        for (std::size_t i=this->next_task++; i<this->job_tasks;
+             i=this->next_task++)
+        {
+            this->job(i);
+        }
+    }
+
+    void work()
+    {
+        unsigned long long seen{ 0 };
+        for (;;)
+        {
+            {
+                std::unique_lock<std::mutex> lock{ this->mutex };
+                this->wake.wait(lock, [this, seen]
+                {
+                    return this->stopping || this->generation != seen;
+                });
+                if (this->stopping)
+                    return;
+                seen = this->generation;
+            }
+            this->drain();
+            {
+                std::lock_guard<std::mutex> lock{ this->mutex };
+                if (--this->active == 0)
+                    this->done.notify_one();
+            }
+        }
+    }
+
+    std::vector<std::thread> workers{};
+    std::mutex mutex{};
+    std::condition_variable wake{};
+    std::condition_variable done{};
+    std::function<void(std::size_t)> job{};
+    std::size_t job_tasks{};
+    std::atomic<std::size_t> next_task{ 0 };
+    std::size_t active{};
+    unsigned long long generation{};
+    bool stopping{ false };
+};
+
+
+namespace fixed_point_detail
+{
+    /*
+     * Elements per chunk, the unit of work of a thread, and per block, the
+     * unit of the vectorized inner loops. Loops with a constant trip count
+     * are vectorized by GCC already at -O2.
+     */
+    constexpr std::size_t reduce_chunk{ 1 << 14 };
+    constexpr std::size_t reduce_block{ 64 };
+
+    /*
+     * The raw integer held by storage integer 'x', wrapped to BITS bits just
+     * like by FixedPointSpan::get().
+     */
+    template <int BITS, typename StorageInt>
+    long long span_raw(StorageInt x) noexcept
+    {
+        using storage_type = typename std::remove_const<StorageInt>::type;
+        using uns_type = typename std::make_unsigned<storage_type>::type;
+        constexpr int SHIFT{ 8*static_cast<int>(sizeof(storage_type)) - BITS };
+        return static_cast<storage_type>(
+                static_cast<uns_type>(static_cast<uns_type>(x) << SHIFT)) >>
+            SHIFT;
+    }
+
+    /*
+     * Call f(i) for i in [begin, end), in blocks of reduce_block elements.
+     */
+    template <typename F>
+    void for_blocks(std::size_t begin, std::size_t end, F f) noexcept
+    {
+        std::size_t i{ begin };
+        for (; i + reduce_block <= end; i += reduce_block)
+            for (std::size_t j=0; j<reduce_block; ++j)
+                f(i + j);
+        for (; i<end; ++i)
+            f(i);
+    }
+
+    /*
+     * Reduce the chunks of n elements, on the threads of 'pool' if there is
+     * one, and combine the partial results in order.
+     */
+    template <typename Partial, typename Chunk, typename Combine>
+    Partial reduce_chunks(FixedPointThreadPool *pool, std::size_t n,
+                          Partial init, Chunk chunk, Combine combine)
+    {
+        const std::size_t chunks{ (n + reduce_chunk - 1) / reduce_chunk };
+        std::vector<Partial> partials(chunks, init);
+        auto task = [&](std::size_t c)
+        {
+            std::size_t begin{ c * reduce_chunk };
+            partials[c] = chunk(begin, std::min(n, begin + reduce_chunk));
+        };
+        if (pool && pool->size() > 1 && chunks > 1)
+        {
+            pool->run(chunks, task);
+        }
+        else
+        {
+            for (std::size_t c=0; c<chunks; ++c)
+                task(c);
+        }
+        Partial res{ init };
+        for (const Partial &partial : partials)
+            res = combine(res, partial);
+        return res;
+    }
+
+    /*
+     * Sum of the raw integers of elements [begin, end) modulo 2^64, which is
+     * exact as long as it fits in 64 bits.
+     */
+    template <int BITS, typename StorageInt>
+    unsigned long long raw_sum(const StorageInt *data, std::size_t begin,
+                               std::size_t end) noexcept
+    {
+        using uns_ll = unsigned long long;
+        uns_ll acc{ 0 };
+        for_blocks(begin, end, [&](std::size_t i)
+        {
+            acc += static_cast<uns_ll>(span_raw<BITS>(data[i]));
+        });
+        return acc;
+    }
+
+    template <int ACC_INT_BITS, int INT_BITS, int FRAC_BITS,
+              typename StorageInt>
+    FixedPoint<ACC_INT_BITS, FRAC_BITS> sum(
+            FixedPointThreadPool *pool,
+            const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x)
+    {
+        using uns_ll = unsigned long long;
+        const StorageInt *data{ x.data() };
+        uns_ll raw{ reduce_chunks(pool, x.size(), uns_ll{ 0 },
+            [data](std::size_t begin, std::size_t end)
+            {
+                return raw_sum<INT_BITS+FRAC_BITS>(data, begin, end);
+            },
+            [](uns_ll a, uns_ll b) { return a + b; }) };
+
+        // Wraps around to ACC_INT_BITS integer bits.
+        FixedPoint<ACC_INT_BITS, FRAC_BITS> res{};
+        res.set_raw(static_cast<long long>(raw));
+        return res;
+    }
+
+    template <int ACC_INT_BITS, int A_INT_BITS, int A_FRAC_BITS,
+              typename A_StorageInt, int B_INT_BITS, int B_FRAC_BITS,
+              typename B_StorageInt>
+    FixedPoint<ACC_INT_BITS, std::min(A_FRAC_BITS+B_FRAC_BITS, 32)> dot(
+            FixedPointThreadPool *pool,
+            const FixedPointSpan<A_INT_BITS, A_FRAC_BITS, A_StorageInt> &a,
+            const FixedPointSpan<B_INT_BITS, B_FRAC_BITS, B_StorageInt> &b)
+    {
+        using uns_ll = unsigned long long;
+        using acc_type =
+            FixedPoint<ACC_INT_BITS, std::min(A_FRAC_BITS+B_FRAC_BITS, 32)>;
+        if (a.size() != b.size())
+        {
+            throw std::runtime_error(
+                "PoorMansFixedPoint: dot product of spans of different size.");
+        }
+
+        /*
+         * Products with no more than 32 fractional bits, whose raw integers
+         * fit in 64 bits, are exact. They are added as raw integers modulo
+         * 2^64, as both the products and the accumulator wrap around in fewer
+         * bits.
+         */
+        if (A_FRAC_BITS+B_FRAC_BITS <= 32 &&
+            A_INT_BITS+A_FRAC_BITS + B_INT_BITS+B_FRAC_BITS <= 64)
+        {
+            const A_StorageInt *data_a{ a.data() };
+            const B_StorageInt *data_b{ b.data() };
+            uns_ll raw{ reduce_chunks(pool, a.size(), uns_ll{ 0 },
+                [data_a, data_b](std::size_t begin, std::size_t end)
+                {
+                    uns_ll acc{ 0 };
+                    for_blocks(begin, end, [&](std::size_t i)
+                    {
+                        acc += static_cast<uns_ll>(
+                            span_raw<A_INT_BITS+A_FRAC_BITS>(data_a[i]) *
+                            span_raw<B_INT_BITS+B_FRAC_BITS>(data_b[i]));
+                    });
+                    return acc;
+                },
+                [](uns_ll x, uns_ll y) { return x + y; }) };
+            acc_type res{};
+            res.set_raw(static_cast<long long>(raw));
+            return res;
+        }
+
+        /*
+         * Other products are rounded by operator*, and accumulated with
+         * FixedPoint arithmetic.
+         */
+        return reduce_chunks(pool, a.size(), acc_type{},
+            [&a, &b](std::size_t begin, std::size_t end)
+            {
+                acc_type acc{};
+                for (std::size_t i=begin; i<end; ++i)
+                    acc += a.get(i) * b.get(i);
+                return acc;
+            },
+            [](const acc_type &x, const acc_type &y) { return x + y; });
+    }
+
+    template <bool MAX, int INT_BITS, int FRAC_BITS, typename StorageInt>
+    FixedPoint<INT_BITS, FRAC_BITS> extremum(
+            FixedPointThreadPool *pool,
+            const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x)
+    {
+        if (x.empty())
+        {
+            throw std::runtime_error(
+                    "PoorMansFixedPoint: extremum of an empty span.");
+        }
+        const StorageInt *data{ x.data() };
+        auto pick = [](long long a, long long b)
+        {
+            return MAX ? std::max(a, b) : std::min(a, b);
+        };
+        const long long init{ MAX ? std::numeric_limits<long long>::min()
+                                  : std::numeric_limits<long long>::max() };
+        long long raw{ reduce_chunks(pool, x.size(), init,
+            [data, init, pick](std::size_t begin, std::size_t end)
+            {
+                long long acc{ init };
+                for_blocks(begin, end, [&](std::size_t i)
+                {
+                    acc = pick(acc, span_raw<INT_BITS+FRAC_BITS>(data[i]));
+                });
+                return acc;
+            },
+            pick) };
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        res.set_raw(raw);
+        return res;
+    }
+
+    template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+    FixedPoint<INT_BITS, FRAC_BITS> mean(
+            FixedPointThreadPool *pool,
+            const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x)
+    {
+        __extension__ typedef __int128 int_128;
+        if (x.empty())
+        {
+            throw std::runtime_error(
+                    "PoorMansFixedPoint: mean of an empty span.");
+        }
+
+        /*
+         * The sum of a chunk of numbers with no more than 32 bits fits in 64
+         * bits, so the raw sum modulo 2^64 is exact. Wider numbers are summed
+         * in 128 bits.
+         */
+        const StorageInt *data{ x.data() };
+        int_128 sum{ reduce_chunks(pool, x.size(), int_128{ 0 },
+            [data](std::size_t begin, std::size_t end)
+            {
+                if (INT_BITS+FRAC_BITS <= 32)
+                {
+                    return int_128{ static_cast<long long>(
+                            raw_sum<INT_BITS+FRAC_BITS>(data, begin, end)) };
+                }
+                int_128 acc{ 0 };
+                for (std::size_t i=begin; i<end; ++i)
+                    acc += span_raw<INT_BITS+FRAC_BITS>(data[i]);
+                return acc;
+            },
+            [](int_128 a, int_128 b) { return a + b; }) };
+
+        // Round, by floor division with the (positive) number of elements.
+        const int_128 n{ static_cast<long long>(x.size()) };
+        const int_128 num{ FRAC_BITS < 32 ? 2*sum + n : sum };
+        const int_128 den{ FRAC_BITS < 32 ? 2*n : n };
+        int_128 quotient{ num / den };
+        if (num < 0 && quotient*den != num)
+            --quotient;
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        res.set_raw(static_cast<long long>(quotient));
+        return res;
+    }
+}
+
+
+/*
+ * Sum of the elements of a span, equal to adding them in order to a
+ * FixedPoint<ACC_INT_BITS, FRAC_BITS> number initialized to zero.
+ */
+template <int ACC_INT_BITS=32, int INT_BITS, int FRAC_BITS,
+          typename StorageInt>
+FixedPoint<ACC_INT_BITS, FRAC_BITS> fixed_point_sum(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x,
+        FixedPointThreadPool &pool)
+{
+    return fixed_point_detail::sum<ACC_INT_BITS>(&pool, x);
+}
+template <int ACC_INT_BITS=32, int INT_BITS, int FRAC_BITS,
+          typename StorageInt>
+FixedPoint<ACC_INT_BITS, FRAC_BITS> fixed_point_sum(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x)
+{
+    return fixed_point_detail::sum<ACC_INT_BITS>(nullptr, x);
+}
+
+/*
+ * Dot product of two spans of equal size, equal to adding the products
+ * a.get(i) * b.get(i) in order to a FixedPoint number of the format
+ * Q(ACC_INT_BITS, FRAC_BITS), where FRAC_BITS is that of the products.
+ */
+template <int ACC_INT_BITS=32, int A_INT_BITS, int A_FRAC_BITS,
+          typename A_StorageInt, int B_INT_BITS, int B_FRAC_BITS,
+          typename B_StorageInt>
+FixedPoint<ACC_INT_BITS, std::min(A_FRAC_BITS+B_FRAC_BITS, 32)>
+    fixed_point_dot(
+        const FixedPointSpan<A_INT_BITS, A_FRAC_BITS, A_StorageInt> &a,
+        const FixedPointSpan<B_INT_BITS, B_FRAC_BITS, B_StorageInt> &b,
+        FixedPointThreadPool &pool)
+{
+    return fixed_point_detail::dot<ACC_INT_BITS>(&pool, a, b);
+}
+template <int ACC_INT_BITS=32, int A_INT_BITS, int A_FRAC_BITS,
+          typename A_StorageInt, int B_INT_BITS, int B_FRAC_BITS,
+          typename B_StorageInt>
+FixedPoint<ACC_INT_BITS, std::min(A_FRAC_BITS+B_FRAC_BITS, 32)>
+    fixed_point_dot(
+        const FixedPointSpan<A_INT_BITS, A_FRAC_BITS, A_StorageInt> &a,
+        const FixedPointSpan<B_INT_BITS, B_FRAC_BITS, B_StorageInt> &b)
+{
+    return fixed_point_detail::dot<ACC_INT_BITS>(nullptr, a, b);
+}
+
+/*
+ * Smallest and largest element of a non-empty span.
+ */
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+FixedPoint<INT_BITS, FRAC_BITS> fixed_point_min(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x,
+        FixedPointThreadPool &pool)
+{
+    return fixed_point_detail::extremum<false>(&pool, x);
+}
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+FixedPoint<INT_BITS, FRAC_BITS> fixed_point_min(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x)
+{
+    return fixed_point_detail::extremum<false>(nullptr, x);
+}
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+FixedPoint<INT_BITS, FRAC_BITS> fixed_point_max(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x,
+        FixedPointThreadPool &pool)
+{
+    return fixed_point_detail::extremum<true>(&pool, x);
+}
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+FixedPoint<INT_BITS, FRAC_BITS> fixed_point_max(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x)
+{
+    return fixed_point_detail::extremum<true>(nullptr, x);
+}
+
+/*
+ * Mean of the elements of a non-empty span. The exact sum is divided by the
+ * number of elements and rounded once, to nearest with ties upwards, or
+ * towards -INF for numbers with 32 fractional bits.
+ */
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+FixedPoint<INT_BITS, FRAC_BITS> fixed_point_mean(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x,
+        FixedPointThreadPool &pool)
+{
+    return fixed_point_detail::mean(&pool, x);
+}
+template <int INT_BITS, int FRAC_BITS, typename StorageInt>
+FixedPoint<INT_BITS, FRAC_BITS> fixed_point_mean(
+        const FixedPointSpan<INT_BITS, FRAC_BITS, StorageInt> &x)
+{
+    return fixed_point_detail::mean(nullptr, x);
+}
+
+#endif
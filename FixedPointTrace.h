@@ -0,0 +1,664 @@
+/*
+ * PoorMansFixedPoint value tracing extension. A FixedPointTraceRecorder dumps
+ * FixedPoint values at named probe points of a running simulation into a
+ * compact binary trace file, for comparison with RTL simulations. Recording a
+ * value does not format, lock or allocate anything: the raw integer, probe id
+ * and time stamp are put into a lock-free ring buffer owned by the recording
+ * thread, and a background thread writes the ring buffers to the trace file.
+ * Only a value that fills a ring half way briefly takes a lock, to wake the
+ * background thread.
+ *
+ *     std::ofstream file{ "sim.trace", std::ios::binary };
+ *     FixedPointTraceRecorder recorder{ file };
+ *     auto acc_probe = recorder.probe<8,24>("fir.acc");
+ *     for (unsigned long long cycle=0; ...; ++cycle)
+ *     {
+ *         FixedPointTraceRecorder::set_time(cycle);
+ *         ...
+ *         acc_probe.record(acc);
+ *     }
+ *
+ * Trace files are converted to text or VCD with fixed_point_trace_to_text()
+ * and fixed_point_trace_to_vcd(), see also tools/trace_convert.cc.
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_TRACE_H
+#define _POOR_MANS_FIXED_POINT_TRACE_H
+
+#include "FixedPoint.h"
+#include "FixedPointIO.h"
+#include <ostream>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cctype>
+
+
+/*
+ * Trace file format, all integers little-endian:
+ *
+ *     offset  size  content
+ *          0     4  Magic "PMFT".
+ *          4     1  Format version, currently 1.
+ *          5     3  Reserved, zero.
+ *
+ * followed by records of two types. A probe record, which always precedes the
+ * values of that probe:
+ *
+ *          0     1  'P'.
+ *          1     4  Probe id.
+ *          5     1  INT_BITS, signed.
+ *          6     1  FRAC_BITS, signed.
+ *          7     2  Length of the probe name.
+ *          9     -  Probe name.
+ *
+ * and a block of values:
+ *
+ *          0     1  'V'.
+ *          1     4  Number of values.
+ *          5     -  Values of 20 bytes each: 8 bytes time stamp, 4 bytes probe
+ *                   id and 8 bytes raw value (see FixedPoint::get_raw()).
+ *
+ * Values of one thread appear in recording order, but the values of different
+ * threads are interleaved block by block.
+ */
+namespace fixed_point_detail
+{
+    constexpr unsigned char TRACE_MAGIC[4] = { 'P', 'M', 'F', 'T' };
+    constexpr unsigned char TRACE_VERSION = 1;
+    constexpr std::size_t TRACE_HEADER_SIZE = 8;
+    constexpr std::size_t TRACE_PROBE_SIZE = 9;
+    constexpr std::size_t TRACE_BLOCK_SIZE = 5;
+    constexpr std::size_t TRACE_VALUE_SIZE = 20;
+
+    /*
+     * Number of values in each per-thread ring buffer, a power of two.
+     */
+    constexpr std::size_t TRACE_RING_VALUES = 1 << 14;
+
+    inline void store_le(unsigned char *p, unsigned long long v, int bytes)
+        noexcept
+    {
+        for (int i=0; i<bytes; ++i)
+            p[i] = static_cast<unsigned char>(v >> (8*i));
+    }
+
+    inline unsigned long long load_le(const unsigned char *p, int bytes)
+        noexcept
+    {
+        unsigned long long v{};
+        for (int i=0; i<bytes; ++i)
+            v |= static_cast<unsigned long long>(p[i]) << (8*i);
+        return v;
+    }
+
+    struct TraceValue
+    {
+        unsigned long long time;
+        long long raw;
+        std::uint32_t probe;
+    };
+
+    /*
+     * Single producer, single consumer ring buffer of trace values. The head
+     * and tail indices only ever increase and are kept on separate cache
+     * lines.
+     */
+    class TraceRing
+    {
+    public:
+        TraceRing() = default;
+        TraceRing(const TraceRing &) = delete;
+        TraceRing &operator=(const TraceRing &) = delete;
+
+        /*
+         * Producer side. Returns the number of values in the ring after the
+         * push, as last seen by the producer, or zero if the ring is full.
+         *
+         * The tail is reloaded whenever the ring looks at least half full,
+         * so while the ring is less than half full the returned count is
+         * never below the actual one, and above that it is the actual one.
+         * Hence a push that brings the ring to half full always returns
+         * TRACE_RING_VALUES/2.
+         */
+        std::size_t try_push(const TraceValue &value) noexcept
+        {
+            std::size_t head = this->head.load(std::memory_order_relaxed);
+            if (head - this->cached_tail >= TRACE_RING_VALUES/2)
+            {
+                this->cached_tail = this->tail.load(std::memory_order_acquire);
+                if (head - this->cached_tail == TRACE_RING_VALUES)
+                    return 0;
+            }
+            this->values[head & (TRACE_RING_VALUES-1)] = value;
+            this->head.store(head+1, std::memory_order_release);
+            return head + 1 - this->cached_tail;
+        }
+
+        /*
+         * Consumer side. Appends all values in the ring to 'out'.
+         */
+        void drain(std::vector<TraceValue> &out)
+        {
+            std::size_t tail = this->tail.load(std::memory_order_relaxed);
+            std::size_t head = this->head.load(std::memory_order_acquire);
+            for (; tail != head; ++tail)
+                out.push_back(this->values[tail & (TRACE_RING_VALUES-1)]);
+            this->tail.store(tail, std::memory_order_release);
+        }
+
+    private:
+        std::atomic<std::size_t> head{ 0 };
+        std::size_t cached_tail{ 0 };
+        char head_padding[64]{};
+        std::atomic<std::size_t> tail{ 0 };
+        char tail_padding[64]{};
+        TraceValue values[TRACE_RING_VALUES]{};
+    };
+
+    /*
+     * Time stamp of values recorded by the current thread.
+     */
+    inline unsigned long long &trace_time() noexcept
+    {
+        static thread_local unsigned long long time{};
+        return time;
+    }
+
+    /*
+     * Ring buffer of the recorder last used by the current thread.
+     */
+    struct TraceThreadCache
+    {
+        unsigned long long recorder;
+        TraceRing *ring;
+    };
+
+    inline TraceThreadCache &trace_thread_cache() noexcept
+    {
+        static thread_local TraceThreadCache cache{ 0, nullptr };
+        return cache;
+    }
+}
+
+
+template <int INT_BITS, int FRAC_BITS>
+class FixedPointTraceProbe;
+
+
+/*
+ * Type FixedPointTraceRecorder begin.
+ *
+ * Records FixedPoint values from any number of threads into trace stream
+ * 'os', which must outlive the recorder. Rings are written to the stream
+ * every 'flush_interval' and when a ring is half full. Threads recording into
+ * a full ring wait for it to be written, no values are ever dropped. The
+ * trace is complete once close() has been called, or the recorder is
+ * destroyed.
+ */
+class FixedPointTraceRecorder
+{
+public:
+    explicit FixedPointTraceRecorder(
+            std::ostream &os,
+            std::chrono::milliseconds flush_interval =
+                std::chrono::milliseconds{ 10 })
+        : os(os), interval{ flush_interval }
+    {
+        using namespace fixed_point_detail;
+        static std::atomic<unsigned long long> next_id{ 1 };
+        this->id = next_id++;
+
+        unsigned char header[TRACE_HEADER_SIZE]{};
+        std::copy(TRACE_MAGIC, TRACE_MAGIC+4, header);
+        header[4] = TRACE_VERSION;
+        this->os.write(reinterpret_cast<const char *>(header),
+                       TRACE_HEADER_SIZE);
+        this->writer = std::thread{ [this] { this->writer_loop(); } };
+    }
+
+    FixedPointTraceRecorder(const FixedPointTraceRecorder &) = delete;
+    FixedPointTraceRecorder &operator=(const FixedPointTraceRecorder &) =
+        delete;
+
+    ~FixedPointTraceRecorder() { this->close(); }
+
+    /*
+     * Register a new probe point for FixedPoint<INT_BITS, FRAC_BITS> values.
+     */
+    template <int INT_BITS, int FRAC_BITS>
+    FixedPointTraceProbe<INT_BITS, FRAC_BITS> probe(const std::string &name)
+    {
+        using namespace fixed_point_detail;
+        static_assert(FRAC_BITS >= 0,
+                "Fractional bits of traced numbers cannot be negative.");
+        if (name.size() > 0xFFFF)
+            throw std::runtime_error(
+                    "PoorMansFixedPoint: trace probe name too long.");
+
+        std::lock_guard<std::mutex> lock{ this->stream_mutex };
+        std::uint32_t probe_id = this->probes++;
+        unsigned char record[TRACE_PROBE_SIZE]{};
+        record[0] = 'P';
+        store_le(record+1, probe_id, 4);
+        record[5] = static_cast<unsigned char>(
+                static_cast<signed char>(INT_BITS));
+        record[6] = static_cast<unsigned char>(
+                static_cast<signed char>(FRAC_BITS));
+        store_le(record+7, name.size(), 2);
+        this->os.write(reinterpret_cast<const char *>(record),
+                       TRACE_PROBE_SIZE);
+        this->os.write(name.data(),
+                       static_cast<std::streamsize>(name.size()));
+        return FixedPointTraceProbe<INT_BITS, FRAC_BITS>{ this, probe_id };
+    }
+
+    /*
+     * Set the time stamp of values subsequently recorded by the calling
+     * thread, e.g, the current clock cycle of the simulation.
+     */
+    static void set_time(unsigned long long time) noexcept
+    {
+        fixed_point_detail::trace_time() = time;
+    }
+
+    /*
+     * Record raw FixedPoint value 'raw' of probe 'probe_id'.
+     */
+    void record(std::uint32_t probe_id, long long raw,
+                unsigned long long time)
+    {
+        fixed_point_detail::TraceThreadCache &cache =
+            fixed_point_detail::trace_thread_cache();
+        if (cache.recorder != this->id)
+        {
+            cache.recorder = this->id;
+            cache.ring = this->thread_ring();
+        }
+        std::size_t fill = cache.ring->try_push({ time, raw, probe_id });
+        if (fill == fixed_point_detail::TRACE_RING_VALUES/2)
+        {
+            // Have the ring written before it fills up.
+            this->request_write();
+        }
+        else if (fill == 0)
+        {
+            ++this->stall_count;
+            do
+            {
+                this->request_write();
+                std::this_thread::yield();
+            } while (!cache.ring->try_push({ time, raw, probe_id }));
+        }
+    }
+
+    /*
+     * Write all recorded values and stop the background thread. No values
+     * may be recorded after this.
+     */
+    void close()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            if (this->stopping)
+                return;
+            this->stopping = true;
+        }
+        this->wake.notify_one();
+        this->writer.join();
+        this->os.flush();
+    }
+
+    /*
+     * Number of times a recording thread had to wait for a full ring buffer.
+     * If non-zero, consider a shorter flush interval.
+     */
+    unsigned long long stalls() const noexcept
+    {
+        return this->stall_count.load();
+    }
+
+private:
+    std::ostream &os;
+    std::chrono::milliseconds interval;
+    unsigned long long id{};
+    std::uint32_t probes{};
+    bool stopping{ false };
+    bool write_requested{ false };
+    std::mutex mutex{};
+    std::mutex stream_mutex{};
+    std::condition_variable wake{};
+    std::map<std::thread::id, std::unique_ptr<fixed_point_detail::TraceRing>>
+        rings{};
+    std::atomic<unsigned long long> stall_count{ 0 };
+    std::thread writer{};
+
+    /*
+     * Wake the background thread to write the rings. The request is set
+     * under the mutex, so it is not lost if the background thread is busy
+     * writing and not yet waiting.
+     */
+    void request_write()
+    {
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            this->write_requested = true;
+        }
+        this->wake.notify_one();
+    }
+
+    fixed_point_detail::TraceRing *thread_ring()
+    {
+        std::lock_guard<std::mutex> lock{ this->mutex };
+        auto &ring = this->rings[std::this_thread::get_id()];
+        if (!ring)
+            ring.reset(new fixed_point_detail::TraceRing{});
+        return ring.get();
+    }
+
+    /*
+     * Background thread, writes the rings to the stream until stopped.
+     */
+    void writer_loop()
+    {
+        using namespace fixed_point_detail;
+        std::vector<TraceRing *> rings{};
+        std::vector<TraceValue> values{};
+        std::vector<unsigned char> block{};
+        std::unique_lock<std::mutex> lock{ this->mutex };
+        for (;;)
+        {
+            // Rings are never removed, so they are written without holding
+            // the mutex, which recording threads take to request a write.
+            bool stop = this->stopping;
+            this->write_requested = false;
+            rings.clear();
+            for (auto &entry : this->rings)
+                rings.push_back(entry.second.get());
+            lock.unlock();
+            {
+                std::lock_guard<std::mutex> stream_lock{ this->stream_mutex };
+                for (TraceRing *ring : rings)
+                {
+                    values.clear();
+                    ring->drain(values);
+                    if (values.empty())
+                        continue;
+                    block.resize(TRACE_BLOCK_SIZE +
+                                 TRACE_VALUE_SIZE * values.size());
+                    block[0] = 'V';
+                    store_le(block.data()+1, values.size(), 4);
+                    unsigned char *p = block.data() + TRACE_BLOCK_SIZE;
+                    for (const TraceValue &value : values)
+                    {
+                        store_le(p, value.time, 8);
+                        store_le(p+8, value.probe, 4);
+                        store_le(p+12,
+                                 static_cast<unsigned long long>(value.raw), 8);
+                        p += TRACE_VALUE_SIZE;
+                    }
+                    this->os.write(
+                            reinterpret_cast<const char *>(block.data()),
+                            static_cast<std::streamsize>(block.size()));
+                }
+            }
+            lock.lock();
+            if (stop)
+                return;
+            this->wake.wait_for(lock, this->interval, [this]
+            {
+                return this->stopping || this->write_requested;
+            });
+        }
+    }
+};
+
+
+/*
+ * Type FixedPointTraceProbe begin.
+ *
+ * Handle of a probe point, created by FixedPointTraceRecorder::probe(). Cheap
+ * to copy and valid as long as the recorder.
+ */
+template <int INT_BITS, int FRAC_BITS>
+class FixedPointTraceProbe
+{
+public:
+    FixedPointTraceProbe(FixedPointTraceRecorder *recorder,
+                         std::uint32_t id) noexcept
+        : recorder{ recorder }, id{ id } {}
+    FixedPointTraceProbe(const FixedPointTraceProbe &) = default;
+    FixedPointTraceProbe &operator=(const FixedPointTraceProbe &) = default;
+
+    /*
+     * Record a value at the time set by FixedPointTraceRecorder::set_time(),
+     * or at an explicit time.
+     */
+    void record(const FixedPoint<INT_BITS, FRAC_BITS> &value) const
+    {
+        this->recorder->record(
+                this->id, value.get_raw(), fixed_point_detail::trace_time());
+    }
+    void record(const FixedPoint<INT_BITS, FRAC_BITS> &value,
+                unsigned long long time) const
+    {
+        this->recorder->record(this->id, value.get_raw(), time);
+    }
+
+private:
+    FixedPointTraceRecorder *recorder;
+    std::uint32_t id;
+};
+
+
+/*
+ * Contents of a trace file, see read_trace().
+ */
+struct FixedPointTrace
+{
+    struct Probe
+    {
+        std::string name;
+        int int_bits;
+        int frac_bits;
+    };
+    struct Value
+    {
+        unsigned long long time;
+        std::uint32_t probe;
+        long long raw;
+    };
+
+    std::vector<Probe> probes;
+    std::vector<Value> values;
+};
+
+/*
+ * Read a complete trace file. Values are sorted by time, values with equal
+ * time stamps stay in file order. Throws std::runtime_error if the file is
+ * corrupt, e.g, has probes of formats that FixedPoint numbers cannot have or
+ * more values than the stream holds.
+ */
+inline FixedPointTrace read_trace(std::istream &is)
+{
+    using namespace fixed_point_detail;
+    auto fail = []
+    {
+        throw std::runtime_error("PoorMansFixedPoint: corrupt trace file.");
+    };
+
+    unsigned char header[TRACE_HEADER_SIZE];
+    if (!is.read(reinterpret_cast<char *>(header), TRACE_HEADER_SIZE) ||
+        !std::equal(TRACE_MAGIC, TRACE_MAGIC+4, header))
+        throw std::runtime_error("PoorMansFixedPoint: not a trace file.");
+    if (header[4] != TRACE_VERSION)
+        throw std::runtime_error(
+                "PoorMansFixedPoint: unsupported trace file version.");
+
+    FixedPointTrace trace{};
+    std::vector<unsigned char> buffer{};
+    char type{};
+    while (is.get(type))
+    {
+        if (type == 'P')
+        {
+            unsigned char record[TRACE_PROBE_SIZE-1];
+            if (!is.read(reinterpret_cast<char *>(record), sizeof(record)))
+                fail();
+            std::size_t probe_id = load_le(record, 4);
+            int int_bits = static_cast<signed char>(record[4]);
+            int frac_bits = static_cast<signed char>(record[5]);
+            std::string name(load_le(record+6, 2), '\0');
+            if (probe_id != trace.probes.size() || !is.read(&name[0],
+                    static_cast<std::streamsize>(name.size())))
+                fail();
+
+            // Formats are used as shift amounts by the converters.
+            if (frac_bits < 0 || frac_bits > 32 ||
+                int_bits + frac_bits < 1 || int_bits + frac_bits > 64)
+                fail();
+            trace.probes.push_back({ name, int_bits, frac_bits });
+        }
+        else if (type == 'V')
+        {
+            unsigned char count_le[TRACE_BLOCK_SIZE-1];
+            if (!is.read(reinterpret_cast<char *>(count_le), sizeof(count_le)))
+                fail();
+
+            // Read in pieces of at most one ring buffer, such that a corrupt
+            // count fails at the end of the stream instead of allocating up
+            // to 2^32 values up front.
+            std::size_t count = load_le(count_le, 4);
+            while (count)
+            {
+                std::size_t piece = std::min(count, TRACE_RING_VALUES);
+                buffer.resize(piece * TRACE_VALUE_SIZE);
+                if (!is.read(reinterpret_cast<char *>(buffer.data()),
+                             static_cast<std::streamsize>(buffer.size())))
+                    fail();
+                for (const unsigned char *p = buffer.data();
+                     p != buffer.data() + buffer.size(); p += TRACE_VALUE_SIZE)
+                {
+                    FixedPointTrace::Value value{ load_le(p, 8),
+                        static_cast<std::uint32_t>(load_le(p+8, 4)),
+                        static_cast<long long>(load_le(p+12, 8)) };
+                    if (value.probe >= trace.probes.size())
+                        fail();
+                    trace.values.push_back(value);
+                }
+                count -= piece;
+            }
+        }
+        else
+            fail();
+    }
+
+    std::stable_sort(trace.values.begin(), trace.values.end(),
+        [](const FixedPointTrace::Value &a, const FixedPointTrace::Value &b)
+        { return a.time < b.time; });
+    return trace;
+}
+
+/*
+ * Convert a trace file to text, one line '<time> <probe> <value>' per value,
+ * ordered by time and with values in exact decimal form.
+ */
+inline void fixed_point_trace_to_text(std::istream &is, std::ostream &os)
+{
+    FixedPointTrace trace = read_trace(is);
+    std::string line{};
+    char text[fixed_point_detail::MAX_TEXT_CHARS];
+    for (const FixedPointTrace::Value &value : trace.values)
+    {
+        const FixedPointTrace::Probe &probe = trace.probes[value.probe];
+        char *end = fixed_point_detail::format_decimal(
+                text, value.raw, probe.frac_bits);
+        line = std::to_string(value.time);
+        line += ' ';
+        line += probe.name;
+        line += ' ';
+        line.append(text, end);
+        line += '\n';
+        os << line;
+    }
+}
+
+/*
+ * Convert a trace file to a Value Change Dump, with every probe as a two's
+ * complement bit vector of INT_BITS+FRAC_BITS bits. Probe names are used as
+ * signal names, with whitespace replaced by underscores.
+ */
+inline void fixed_point_trace_to_vcd(std::istream &is, std::ostream &os,
+                                     const std::string &timescale = "1ns")
+{
+    FixedPointTrace trace = read_trace(is);
+
+    // Printable VCD identifier codes, '!' to '~'.
+    auto code = [](std::size_t n)
+    {
+        std::string res{};
+        do
+        {
+            res += static_cast<char>('!' + n % 94);
+            n /= 94;
+        } while (n);
+        return res;
+    };
+
+    os << "$timescale " << timescale << " $end\n";
+    os << "$scope module fixed_point_trace $end\n";
+    for (std::size_t i=0; i<trace.probes.size(); ++i)
+    {
+        const FixedPointTrace::Probe &probe = trace.probes[i];
+        std::string name = probe.name;
+        auto space = [](char c)
+        {
+            return std::isspace(static_cast<unsigned char>(c)) != 0;
+        };
+        std::replace_if(name.begin(), name.end(), space, '_');
+        os << "$var wire " << probe.int_bits + probe.frac_bits << " "
+           << code(i) << " " << name << " $end\n";
+        os << "$comment " << name << " is Q(" << probe.int_bits << ","
+           << probe.frac_bits << ") $end\n";
+    }
+    os << "$upscope $end\n$enddefinitions $end\n";
+
+    bool first = true;
+    unsigned long long time{};
+    std::string bits{};
+    for (const FixedPointTrace::Value &value : trace.values)
+    {
+        if (first || value.time != time)
+        {
+            time = value.time;
+            first = false;
+            os << "#" << time << "\n";
+        }
+        const FixedPointTrace::Probe &probe = trace.probes[value.probe];
+        int width = probe.int_bits + probe.frac_bits;
+        bits.assign(1, 'b');
+        for (int i=width-1; i>=0; --i)
+            bits += ((static_cast<unsigned long long>(value.raw) >> i) & 1)
+                    ? '1' : '0';
+        os << bits << " " << code(value.probe) << "\n";
+    }
+}
+
+
+/*
+ * Include guard end.
+ */
+#endif
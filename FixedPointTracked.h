@@ -0,0 +1,415 @@
+/*
+ * PoorMansFixedPoint error tracking extension. A TrackedFixedPoint number
+ * carries an ideal, double precision, shadow value alongside the FixedPoint
+ * value through every arithmetic operation. Running a pipeline once on
+ * TrackedFixedPoint numbers measures its quantization error directly, instead
+ * of running it twice, in floating point and in fixed point, and comparing
+ * the outputs.
+ *
+ * Quantization error statistics are gathered per tag by calling record() on
+ * the numbers of interest, e.g, the output samples of a filter:
+ *
+ *     TrackedFixedPoint<1,15> y = fir(x);
+ *     y.record("fir_output");
+ *     ...
+ *     fixed_point_report_errors(std::cout);
+ *
+ * Everything in here is built on top of the public interface of FixedPoint.h,
+ * and the core header does not depend on this one.
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_TRACKED_H
+#define _POOR_MANS_FIXED_POINT_TRACKED_H
+
+#include "FixedPoint.h"
+#include <ostream>
+#include <string>
+#include <map>
+#include <mutex>
+#include <cmath>
+#include <limits>
+#include <utility>
+#include <algorithm>
+
+
+/*
+ * Quantization error statistics, the difference between FixedPoint values and
+ * their ideal values.
+ */
+class FixedPointErrorStats
+{
+public:
+    /*
+     * Add one sample of a FixedPoint value and its ideal value.
+     */
+    void add(double value, double ideal) noexcept
+    {
+        double error = value - ideal;
+        ++this->samples;
+        this->sum_error += error;
+        this->sum_sq_error += error * error;
+        this->sum_sq_ideal += ideal * ideal;
+        this->max_error = std::max(this->max_error, std::abs(error));
+    }
+
+    /*
+     * Merge the samples of another set of statistics into this one.
+     */
+    void merge(const FixedPointErrorStats &rhs) noexcept
+    {
+        this->samples += rhs.samples;
+        this->sum_error += rhs.sum_error;
+        this->sum_sq_error += rhs.sum_sq_error;
+        this->sum_sq_ideal += rhs.sum_sq_ideal;
+        this->max_error = std::max(this->max_error, rhs.max_error);
+    }
+
+    unsigned long long count() const noexcept { return this->samples; }
+    double max_abs_error() const noexcept { return this->max_error; }
+
+    /*
+     * Mean error, positive if the FixedPoint values are biased upwards.
+     */
+    double bias() const noexcept
+    {
+        return this->samples ?
+            this->sum_error / static_cast<double>(this->samples) : 0.0;
+    }
+
+    /*
+     * Root mean square error.
+     */
+    double rms_error() const noexcept
+    {
+        return this->samples ?
+            std::sqrt(this->sum_sq_error / static_cast<double>(this->samples))
+            : 0.0;
+    }
+
+    /*
+     * Signal to quantization noise ratio in dB, infinity without any error.
+     */
+    double sqnr_db() const noexcept
+    {
+        if (this->sum_sq_error == 0.0)
+            return std::numeric_limits<double>::infinity();
+        return 10.0 * std::log10(this->sum_sq_ideal / this->sum_sq_error);
+    }
+
+    /*
+     * Summary string, good for printouts.
+     */
+    std::string to_string() const
+    {
+        return std::to_string(this->samples) + " samples, "
+            + "max error " + std::to_string(this->max_abs_error()) + ", "
+            + "bias " + std::to_string(this->bias()) + ", "
+            + "rms error " + std::to_string(this->rms_error()) + ", "
+            + "SQNR " + std::to_string(this->sqnr_db()) + " dB";
+    }
+
+private:
+    unsigned long long samples{};
+    double sum_error{};
+    double sum_sq_error{};
+    double sum_sq_ideal{};
+    double max_error{};
+};
+
+
+namespace fixed_point_detail
+{
+    /*
+     * Process wide error statistics per tag. Threads record into thread local
+     * tables, keyed by tag pointer, which are merged here when a thread exits
+     * or reports.
+     */
+    class ErrorRegistry
+    {
+    public:
+        ErrorRegistry() = default;
+        ErrorRegistry(const ErrorRegistry &) = delete;
+        ErrorRegistry &operator=(const ErrorRegistry &) = delete;
+
+        void merge(const std::string &tag, const FixedPointErrorStats &stats)
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            this->stats[tag].merge(stats);
+        }
+
+        std::map<std::string, FixedPointErrorStats> get()
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            return this->stats;
+        }
+
+        void clear()
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            this->stats.clear();
+        }
+
+    private:
+        std::mutex mutex{};
+        std::map<std::string, FixedPointErrorStats> stats{};
+    };
+
+    inline ErrorRegistry &error_registry()
+    {
+        static ErrorRegistry registry{};
+        return registry;
+    }
+
+    class ThreadErrorStats
+    {
+    public:
+        ThreadErrorStats() { error_registry(); }
+        ThreadErrorStats(const ThreadErrorStats &) = delete;
+        ThreadErrorStats &operator=(const ThreadErrorStats &) = delete;
+        ~ThreadErrorStats() { this->flush(); }
+
+        void add(const char *tag, double value, double ideal)
+        {
+            this->stats[tag].add(value, ideal);
+        }
+
+        void flush()
+        {
+            for (const auto &entry : this->stats)
+                error_registry().merge(entry.first, entry.second);
+            this->stats.clear();
+        }
+
+    private:
+        std::map<const char *, FixedPointErrorStats> stats{};
+    };
+
+    inline ThreadErrorStats &thread_error_stats()
+    {
+        static thread_local ThreadErrorStats stats{};
+        return stats;
+    }
+
+    template <typename T>
+    struct tracked_of;
+}
+
+
+/*
+ * Type TrackedFixedPoint begin.
+ *
+ * A FixedPoint number with an ideal shadow value. Arithmetic results have the
+ * same formats as for FixedPoint numbers, and comparisons compare the
+ * FixedPoint values. Plain FixedPoint operands have to be converted
+ * explicitly, in which case their exact value becomes the ideal value.
+ */
+template <int INT_BITS, int FRAC_BITS>
+class TrackedFixedPoint : public FixedPoint<INT_BITS, FRAC_BITS>
+{
+    using fixed_type = FixedPoint<INT_BITS, FRAC_BITS>;
+
+    /*
+     * The ideal value of the number.
+     */
+    double ideal_value{};
+
+    template <int _INT_BITS, int _FRAC_BITS>
+    friend class TrackedFixedPoint;
+
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    static const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &
+        fixed(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        return rhs;
+    }
+
+    /*
+     * Create tracked result of some FixedPoint operation.
+     */
+    template <int RES_INT_BITS, int RES_FRAC_BITS>
+    static TrackedFixedPoint<RES_INT_BITS, RES_FRAC_BITS>
+        make(const FixedPoint<RES_INT_BITS, RES_FRAC_BITS> &value,
+             double ideal) noexcept
+    {
+        TrackedFixedPoint<RES_INT_BITS, RES_FRAC_BITS> res{ value };
+        res.ideal_value = ideal;
+        return res;
+    }
+
+public:
+    TrackedFixedPoint() = default;
+
+    /*
+     * Constructors, the ideal value is the exact value of the argument.
+     */
+    explicit TrackedFixedPoint(double a)
+        : fixed_type{ a }, ideal_value{ a } {}
+    explicit TrackedFixedPoint(int n) noexcept
+        : fixed_type{ n }, ideal_value{ static_cast<double>(n) } {}
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    explicit TrackedFixedPoint(
+            const FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs) noexcept
+        : fixed_type{ rhs }, ideal_value{ static_cast<double>(rhs) } {}
+
+    /*
+     * Conversion from other tracked numbers keeps the ideal value.
+     */
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint(
+            const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+        : fixed_type{ fixed(rhs) }, ideal_value{ rhs.ideal_value } {}
+    TrackedFixedPoint(const TrackedFixedPoint &rhs) = default;
+
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint &
+        operator=(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        fixed_type::operator=(fixed(rhs));
+        this->ideal_value = rhs.ideal_value;
+        return *this;
+    }
+    TrackedFixedPoint &operator=(const TrackedFixedPoint &rhs) = default;
+
+    /*
+     * The ideal value and the quantization error of the number.
+     */
+    double ideal() const noexcept { return this->ideal_value; }
+    double error() const noexcept
+    {
+        return static_cast<double>(fixed(*this)) - this->ideal_value;
+    }
+
+    /*
+     * Add the quantization error of this number to the statistics of 'tag'.
+     * The tag string must stay alive until the statistics have been reported.
+     */
+    void record(const char *tag) const
+    {
+        fixed_point_detail::thread_error_stats().add(
+                tag, static_cast<double>(fixed(*this)), this->ideal_value);
+    }
+
+    /*
+     * Arithmetic, see FixedPoint for the result formats.
+     */
+    TrackedFixedPoint operator-() const noexcept
+    {
+        return make(-fixed(*this), -this->ideal_value);
+    }
+
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint
+        operator+(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return make(fixed(*this) + fixed(rhs),
+                    this->ideal_value + rhs.ideal_value);
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint
+        operator-(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return make(fixed(*this) - fixed(rhs),
+                    this->ideal_value - rhs.ideal_value);
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    typename fixed_point_detail::tracked_of<decltype(
+        std::declval<fixed_type>() *
+        std::declval<FixedPoint<RHS_INT_BITS, RHS_FRAC_BITS>>())>::type
+        operator*(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const noexcept
+    {
+        return make(fixed(*this) * fixed(rhs),
+                    this->ideal_value * rhs.ideal_value);
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint
+        operator/(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        const
+    {
+        return make(fixed(*this) / fixed(rhs),
+                    this->ideal_value / rhs.ideal_value);
+    }
+
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint &
+        operator+=(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        return *this = *this + rhs;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint &
+        operator-=(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        return *this = *this - rhs;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint &
+        operator*=(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+        noexcept
+    {
+        return *this = *this * rhs;
+    }
+    template <int RHS_INT_BITS, int RHS_FRAC_BITS>
+    TrackedFixedPoint &
+        operator/=(const TrackedFixedPoint<RHS_INT_BITS, RHS_FRAC_BITS> &rhs)
+    {
+        return *this = *this / rhs;
+    }
+};
+
+namespace fixed_point_detail
+{
+    template <int INT_BITS, int FRAC_BITS>
+    struct tracked_of<FixedPoint<INT_BITS, FRAC_BITS>>
+    {
+        using type = TrackedFixedPoint<INT_BITS, FRAC_BITS>;
+    };
+}
+
+
+/*
+ * Error statistics of 'tag' recorded so far, including those of the calling
+ * thread, but not those of other still running threads.
+ */
+inline FixedPointErrorStats fixed_point_error_stats(const std::string &tag)
+{
+    fixed_point_detail::thread_error_stats().flush();
+    auto stats = fixed_point_detail::error_registry().get();
+    auto it = stats.find(tag);
+    return it == stats.end() ? FixedPointErrorStats{} : it->second;
+}
+
+/*
+ * Print the error statistics of every tag recorded so far, including those of
+ * the calling thread, but not those of other still running threads.
+ */
+inline void fixed_point_report_errors(std::ostream &os)
+{
+    fixed_point_detail::thread_error_stats().flush();
+    for (const auto &entry : fixed_point_detail::error_registry().get())
+        os << entry.first << ": " << entry.second.to_string() << "\n";
+}
+
+/*
+ * Forget all error statistics recorded so far.
+ */
+inline void fixed_point_clear_errors()
+{
+    fixed_point_detail::thread_error_stats().flush();
+    fixed_point_detail::error_registry().clear();
+}
+
+
+/*
+ * Include guard end.
+ */
+#endif
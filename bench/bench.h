@@ -0,0 +1,569 @@
+/*
+ * PoorMansFixedPoint micro-benchmark harness. A small, header only harness
+ * for timing short pieces of code with warm-up, repetitions and statistics.
+ *
+ * Each benchmark is a callable taking the number of operations to perform. The
+ * harness first calibrates the number of operations so that a single
+ * repetition runs for at least '--min-time' milliseconds, this doubles as
+ * warm-up. It then times '--reps' repetitions and reports the mean, standard
+ * deviation and minimum time per operation.
+ *
+ * On Linux, hardware performance counters (cycles, instructions, branch misses,
+ * L1 data cache and last level cache misses) are read through perf_event_open
+ * around the timed repetitions, and cycles/op and IPC are reported next to the
+ * wall-clock time. Counters that cannot be opened, e.g, due to
+ * /proc/sys/kernel/perf_event_paranoid or missing hardware support, are
+ * reported as unavailable.
+ *
+ * Command line options understood by bench::Runner:
+ *
+ *   --filter <str>   Only run benchmarks whose name contains <str>.
+ *   --reps <n>       Number of timed repetitions (default 10).
+ *   --min-time <ms>  Minimum time of a single repetition (default 20).
+ *   --json <file>    Write results as JSON to <file>.
+ *   --no-perf        Do not read hardware performance counters.
+ *
+ *   --save-baseline <file>  Store results as a baseline in <file>.
+ *   --baseline <file>       Compare results against the baseline in <file>,
+ *                           and exit with a non-zero code if any benchmark has
+ *                           regressed significantly.
+ *   --threshold <pct>       Smallest change in ns/op considered a regression
+ *                           (default 5).
+ *
+ * Author: Mikael Henriksson [www.github.com/miklhh]
+ */
+
+#ifndef _POOR_MANS_FIXED_POINT_BENCH_H
+#define _POOR_MANS_FIXED_POINT_BENCH_H
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <map>
+
+#if defined(__linux__)
+    #include <linux/perf_event.h>
+    #include <sys/ioctl.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+namespace bench
+{
+    /*
+     * Prevent the compiler from optimizing away the computation of 'value'.
+     */
+    template <typename T>
+    inline void do_not_optimize(const T &value) noexcept
+    {
+        asm volatile("" : : "r,m"(value) : "memory");
+    }
+
+    /*
+     * Force the compiler to assume that all memory has been read and written.
+     */
+    inline void clobber_memory() noexcept
+    {
+        asm volatile("" : : : "memory");
+    }
+
+    /*
+     * Hardware performance counters of the calling thread, read through the
+     * Linux perf_event_open system call. Each counter is opened separately,
+     * so that the available ones can be used even if others are not, and
+     * counts are scaled if the kernel multiplexes the counters.
+     */
+    class PerfCounters
+    {
+    public:
+        enum Counter
+        {
+            CYCLES, INSTRUCTIONS, BRANCH_MISSES, L1D_MISSES, LLC_MISSES,
+            NUM_COUNTERS
+        };
+
+        explicit PerfCounters(bool enable)
+            : fds{}
+        {
+            for (int &fd : this->fds)
+                fd = -1;
+        #if defined(__linux__)
+            if (!enable)
+                return;
+            const unsigned long long L1D_READ_MISS =
+                PERF_COUNT_HW_CACHE_L1D
+                | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            const struct { unsigned type; unsigned long long config; }
+            events[NUM_COUNTERS] = {
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+                { PERF_TYPE_HW_CACHE, L1D_READ_MISS },
+                { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES }
+            };
+            for (int i=0; i<NUM_COUNTERS; ++i)
+            {
+                perf_event_attr attr{};
+                attr.size = sizeof(attr);
+                attr.type = events[i].type;
+                attr.config = events[i].config;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED
+                                 | PERF_FORMAT_TOTAL_TIME_RUNNING;
+                this->fds[i] = static_cast<int>(
+                        ::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            }
+        #else
+            (void) enable;
+        #endif
+        }
+
+        PerfCounters(const PerfCounters &) = delete;
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        ~PerfCounters()
+        {
+        #if defined(__linux__)
+            for (int fd : this->fds)
+            {
+                if (fd >= 0)
+                    ::close(fd);
+            }
+        #endif
+        }
+
+        bool any_available() const noexcept
+        {
+            return std::any_of(std::begin(this->fds), std::end(this->fds),
+                               [](int fd) { return fd >= 0; });
+        }
+
+        /*
+         * Reset and start all counters.
+         */
+        void start() noexcept
+        {
+        #if defined(__linux__)
+            for (int fd : this->fds)
+            {
+                if (fd >= 0)
+                {
+                    ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                    ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+                }
+            }
+        #endif
+        }
+
+        /*
+         * Stop all counters.
+         */
+        void stop() noexcept
+        {
+        #if defined(__linux__)
+            for (int fd : this->fds)
+            {
+                if (fd >= 0)
+                    ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        #endif
+        }
+
+        /*
+         * Value of counter 'c' since the last start(), or NaN if the counter
+         * is unavailable.
+         */
+        double read(Counter c) const noexcept
+        {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+        #if defined(__linux__)
+            unsigned long long values[3]{};
+            if (this->fds[c] < 0 ||
+                ::read(this->fds[c], values, sizeof(values))
+                    != static_cast<ssize_t>(sizeof(values)) ||
+                values[2] == 0)
+            {
+                return nan;
+            }
+            // Scale for time the counter was multiplexed out.
+            return static_cast<double>(values[0])
+                * static_cast<double>(values[1])
+                / static_cast<double>(values[2]);
+        #else
+            (void) c;
+            return nan;
+        #endif
+        }
+
+    private:
+        int fds[NUM_COUNTERS];
+    };
+
+    /*
+     * Result of a single benchmark. Hardware counter values are per
+     * operation, and NaN if unavailable.
+     */
+    struct Result
+    {
+        std::string name;
+        std::string format;
+        double mean_ns;
+        double stddev_ns;
+        double min_ns;
+        std::size_t reps;
+        std::size_t ops_per_rep;
+        double cycles;
+        double instructions;
+        double branch_misses;
+        double l1d_misses;
+        double llc_misses;
+
+        double ops_per_sec() const noexcept { return 1e9 / this->mean_ns; }
+        double ipc() const noexcept
+        {
+            return this->instructions / this->cycles;
+        }
+    };
+
+    /*
+     * Benchmark runner, collecting and reporting results.
+     */
+    class Runner
+    {
+    public:
+        Runner(int argc, char **argv)
+            : filter{}, json_path{}, baseline_path{}, save_baseline_path{},
+              reps{ 10 }, min_time_ms{ 20 }, threshold_pct{ 5.0 },
+              results{}, perf{ enable_perf(argc, argv) }
+        {
+            for (int i=1; i<argc; ++i)
+            {
+                std::string arg{ argv[i] };
+                bool has_value{ i+1 < argc };
+                if (arg == "--filter" && has_value)
+                    this->filter = argv[++i];
+                else if (arg == "--reps" && has_value)
+                    this->reps = std::max(2, std::atoi(argv[++i]));
+                else if (arg == "--min-time" && has_value)
+                    this->min_time_ms = std::max(1, std::atoi(argv[++i]));
+                else if (arg == "--json" && has_value)
+                    this->json_path = argv[++i];
+                else if (arg == "--baseline" && has_value)
+                    this->baseline_path = argv[++i];
+                else if (arg == "--save-baseline" && has_value)
+                    this->save_baseline_path = argv[++i];
+                else if (arg == "--threshold" && has_value)
+                    this->threshold_pct = std::atof(argv[++i]);
+                else if (arg == "--no-perf")
+                    continue;
+                else
+                    std::cerr << "Ignoring unknown option: " << arg << "\n";
+            }
+            if (enable_perf(argc, argv) && !this->perf.any_available())
+                std::cerr << "Hardware performance counters unavailable.\n";
+        }
+
+        /*
+         * Run benchmark 'name' of FixedPoint format(s) 'format'. The callable
+         * 'body(n)' should perform 'n' operations.
+         */
+        template <typename Body>
+        void run(const std::string &name, const std::string &format,
+                 Body &&body)
+        {
+            using clock = std::chrono::steady_clock;
+            if (name.find(this->filter) == std::string::npos)
+                return;
+
+            /*
+             * Calibration and warm-up. Grow the number of operations until a
+             * repetition takes at least the minimum time.
+             */
+            const double min_ns = this->min_time_ms * 1e6;
+            std::size_t ops{ 1024 };
+            for (;;)
+            {
+                auto t1 = clock::now();
+                body(ops);
+                auto t2 = clock::now();
+                double ns = std::chrono::duration<double, std::nano>(
+                        t2 - t1).count();
+                if (ns >= min_ns)
+                    break;
+                ops = static_cast<std::size_t>(
+                        ops * std::min(10.0, 1.2 * min_ns / std::max(ns, 1.0)));
+            }
+
+            /*
+             * Timed repetitions, with hardware counters running throughout.
+             */
+            std::vector<double> samples{};
+            this->perf.start();
+            for (int rep=0; rep<this->reps; ++rep)
+            {
+                auto t1 = clock::now();
+                body(ops);
+                auto t2 = clock::now();
+                samples.push_back(std::chrono::duration<double, std::nano>(
+                        t2 - t1).count() / static_cast<double>(ops));
+            }
+            this->perf.stop();
+            const double total_ops =
+                static_cast<double>(ops) * static_cast<double>(this->reps);
+
+            double mean{}, var{};
+            for (double s : samples)
+                mean += s;
+            mean /= static_cast<double>(samples.size());
+            for (double s : samples)
+                var += (s - mean) * (s - mean);
+            var /= static_cast<double>(samples.size() - 1);
+
+            Result res{
+                name, format, mean, std::sqrt(var),
+                *std::min_element(samples.begin(), samples.end()),
+                samples.size(), ops,
+                this->perf.read(PerfCounters::CYCLES) / total_ops,
+                this->perf.read(PerfCounters::INSTRUCTIONS) / total_ops,
+                this->perf.read(PerfCounters::BRANCH_MISSES) / total_ops,
+                this->perf.read(PerfCounters::L1D_MISSES) / total_ops,
+                this->perf.read(PerfCounters::LLC_MISSES) / total_ops
+            };
+            this->print(res);
+            this->results.push_back(res);
+        }
+
+        /*
+         * Write results to the JSON file and the baseline file, and compare
+         * against a stored baseline, as requested on the command line. Returns
+         * the process exit code, which is non-zero if a regression is found.
+         */
+        int finish() const
+        {
+            int res{};
+            if (!this->baseline_path.empty() && this->compare_baseline() != 0)
+                res = 1;
+            if (!this->json_path.empty() && !this->write_json(this->json_path))
+                res = 1;
+            if (!this->save_baseline_path.empty() &&
+                !this->write_json(this->save_baseline_path))
+            {
+                res = 1;
+            }
+            return res;
+        }
+
+    private:
+        /*
+         * Write results as JSON, one benchmark per line. Returns false if the
+         * file cannot be written.
+         */
+        bool write_json(const std::string &path) const
+        {
+            std::ofstream os{ path };
+            if (!os)
+            {
+                std::cerr << "Cannot open " << path << "\n";
+                return false;
+            }
+            os << std::setprecision(6) << "{\n  \"benchmarks\": [\n";
+            for (std::size_t i=0; i<this->results.size(); ++i)
+            {
+                const Result &r = this->results[i];
+                os << "    { \"name\": \"" << r.name << "\""
+                   << ", \"format\": \"" << r.format << "\""
+                   << ", \"ns_per_op\": " << r.mean_ns
+                   << ", \"stddev_ns\": " << r.stddev_ns
+                   << ", \"min_ns\": " << r.min_ns
+                   << ", \"ops_per_sec\": " << r.ops_per_sec()
+                   << ", \"reps\": " << r.reps
+                   << ", \"ops_per_rep\": " << r.ops_per_rep
+                   << ", \"cycles_per_op\": " << json_number(r.cycles)
+                   << ", \"instructions_per_op\": "
+                   << json_number(r.instructions)
+                   << ", \"ipc\": " << json_number(r.ipc())
+                   << ", \"branch_misses_per_op\": "
+                   << json_number(r.branch_misses)
+                   << ", \"l1d_misses_per_op\": " << json_number(r.l1d_misses)
+                   << ", \"llc_misses_per_op\": " << json_number(r.llc_misses)
+                   << " }"
+                   << (i+1 < this->results.size() ? ",\n" : "\n");
+            }
+            os << "  ]\n}\n";
+            return static_cast<bool>(os);
+        }
+
+        /*
+         * Value of 'key' in a single line JSON object written by
+         * write_json(), or an empty string if not present.
+         */
+        static std::string json_field(const std::string &line,
+                                      const std::string &key)
+        {
+            const std::string pattern{ "\"" + key + "\": " };
+            std::size_t pos = line.find(pattern);
+            if (pos == std::string::npos)
+                return "";
+            pos += pattern.size();
+            if (line[pos] == '"')
+                return line.substr(pos+1, line.find('"', pos+1) - pos - 1);
+            return line.substr(pos, line.find_first_of(",}", pos) - pos);
+        }
+
+        /*
+         * Compare the results against the baseline file. A benchmark has
+         * regressed if its mean time per operation grew by more than the
+         * threshold, and the growth is statistically significant according
+         * to a one-sided Welch's t-test at the 1% level. Returns the number of
+         * regressions found, or -1 if the baseline cannot be read.
+         */
+        int compare_baseline() const
+        {
+            struct Baseline { double mean; double stddev; double reps; };
+            std::ifstream is{ this->baseline_path };
+            if (!is)
+            {
+                std::cerr << "Cannot open " << this->baseline_path << "\n";
+                return -1;
+            }
+            std::map<std::string, Baseline> baseline{};
+            for (std::string line; std::getline(is, line); )
+            {
+                std::string name{ json_field(line, "name") };
+                if (name.empty())
+                    continue;
+                baseline[name + " " + json_field(line, "format")] = Baseline{
+                    std::atof(json_field(line, "ns_per_op").c_str()),
+                    std::atof(json_field(line, "stddev_ns").c_str()),
+                    std::atof(json_field(line, "reps").c_str())
+                };
+            }
+
+            std::cout << "\nComparison against baseline "
+                      << this->baseline_path << " (threshold "
+                      << this->threshold_pct << "%):" << std::endl;
+            int regressions{};
+            for (const Result &r : this->results)
+            {
+                auto it = baseline.find(r.name + " " + r.format);
+                std::cout << "    " << std::left << std::setw(28) << r.name
+                          << std::setw(24) << r.format << std::right;
+                if (it == baseline.end())
+                {
+                    std::cout << "not in baseline" << std::endl;
+                    continue;
+                }
+                const Baseline &b = it->second;
+                const double n = static_cast<double>(r.reps);
+                const double var_r = r.stddev_ns * r.stddev_ns / n;
+                const double var_b = b.stddev * b.stddev / b.reps;
+                const double se = std::sqrt(var_r + var_b);
+                const double change = 100.0 * (r.mean_ns / b.mean - 1.0);
+                const double t = se > 0 ? (r.mean_ns - b.mean) / se
+                    : (r.mean_ns > b.mean ? 1.0 : -1.0)
+                      * std::numeric_limits<double>::infinity();
+
+                /*
+                 * Welch-Satterthwaite degrees of freedom, and a first order
+                 * Cornish-Fisher approximation of the 99% quantile of the
+                 * t-distribution.
+                 */
+                const double dof = se > 0 ? (se*se*se*se) /
+                    (var_r*var_r/(n-1) + var_b*var_b/(b.reps-1)) : 1.0;
+                const double z = 2.326;
+                const double t_crit = z + (z*z*z + z) / (4*dof);
+
+                std::ios_base::fmtflags flags{ std::cout.flags() };
+                std::cout << std::fixed << std::setprecision(3)
+                          << std::setw(10) << b.mean << " -> "
+                          << std::setw(10) << r.mean_ns << " ns/op  "
+                          << std::showpos << std::setprecision(1)
+                          << std::setw(7) << change << "%" << std::noshowpos;
+                std::cout.flags(flags);
+                if (change > this->threshold_pct && t > t_crit)
+                {
+                    std::cout << "  REGRESSION";
+                    ++regressions;
+                }
+                else if (change < -this->threshold_pct && t < -t_crit)
+                {
+                    std::cout << "  improvement";
+                }
+                std::cout << std::endl;
+            }
+            std::cout << regressions << " regression(s) found." << std::endl;
+            return regressions;
+        }
+
+        static bool enable_perf(int argc, char **argv)
+        {
+            for (int i=1; i<argc; ++i)
+            {
+                if (std::strcmp(argv[i], "--no-perf") == 0)
+                    return false;
+            }
+            return true;
+        }
+
+        /*
+         * JSON has no NaN, unavailable values are written as null.
+         */
+        static std::string json_number(double d)
+        {
+            if (std::isnan(d))
+                return "null";
+            std::ostringstream os{};
+            os << std::setprecision(6) << d;
+            return os.str();
+        }
+
+        void print(const Result &r) const
+        {
+            std::ios_base::fmtflags flags{ std::cout.flags() };
+            std::cout << std::left << std::setw(28) << r.name
+                      << std::setw(24) << r.format << std::right
+                      << std::fixed << std::setprecision(3)
+                      << std::setw(10) << r.mean_ns << " ns/op  +- "
+                      << std::setw(7) << r.stddev_ns << "  (min "
+                      << std::setw(8) << r.min_ns << ")  "
+                      << std::setprecision(1) << std::setw(8)
+                      << r.ops_per_sec() / 1e6 << " Mops/s";
+            if (!std::isnan(r.cycles))
+            {
+                std::cout << std::setprecision(2)
+                          << "  " << std::setw(9) << r.cycles << " cyc/op"
+                          << "  IPC " << std::setw(5) << r.ipc();
+            }
+            std::cout << std::endl;
+            std::cout.flags(flags);
+        }
+
+        std::string filter;
+        std::string json_path;
+        std::string baseline_path;
+        std::string save_baseline_path;
+        int reps;
+        int min_time_ms;
+        double threshold_pct;
+        std::vector<Result> results;
+        PerfCounters perf;
+    };
+}
+
+/*
+ * Include guard end.
+ */
+#endif
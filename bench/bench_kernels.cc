@@ -0,0 +1,585 @@
+/*
+ * Application kernel benchmarks. Every kernel is implemented with FixedPoint,
+ * double, float and hand-written integer arithmetic, so that the overhead of
+ * the FixedPoint abstraction over hand-rolled integer code can be tracked over
+ * time. The integer versions use the same Q-formats as the FixedPoint versions
+ * and round to nearest where the FixedPoint versions round. The dot product is
+ * also computed with ExactFixedPoint numbers, which never round.
+ *
+ * The operation timed by ns/op differs between kernels:
+ *
+ *   dot        One multiply-accumulate of a 1024 element dot product.
+ *   fir        One output sample of a 32 tap FIR filter.
+ *   biquad     One output sample of a direct form I biquad.
+ *   fft256     One complex 256-point radix-2 FFT.
+ *   leibniz    One iteration of the Leibniz loop of tests/test.cc.
+ *   bernoulli  One iteration of the Bernoulli loop of tests/test.cc.
+ *   matmul     One multiply-accumulate of a 32x32 matrix multiplication.
+ */
+
+#include "bench.h"
+#include "FixedPoint.h"
+#include "FixedPointExact.h"
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    __extension__ typedef __int128 int128;
+
+    using fix_sample = FixedPoint<1,15>;
+
+    constexpr std::size_t DOT_LEN = 1024;
+    constexpr std::size_t FIR_TAPS = 32;
+    constexpr std::size_t FIR_LEN = 1024;
+    constexpr std::size_t BIQUAD_LEN = 1024;
+    constexpr std::size_t FFT_LEN = 256;
+    constexpr std::size_t LOOP_ITERATIONS = 10000;
+    constexpr std::size_t MAT_DIM = 32;
+
+    const double PI = 3.14159265358979323846;
+
+    /*
+     * Run 'block()' repeatedly until at least 'ops' operations are performed,
+     * where a single call of 'block()' performs 'ops_per_block' operations.
+     */
+    template <typename Block>
+    void run_blocks(bench::Runner &runner, const std::string &name,
+                    const std::string &format, std::size_t ops_per_block,
+                    Block block)
+    {
+        runner.run(name, format, [&](std::size_t ops)
+        {
+            for (std::size_t done=0; done<ops; done+=ops_per_block)
+            {
+                block();
+                bench::clobber_memory();
+            }
+        });
+    }
+
+    /*
+     * Uniformly distributed random signal in [-0.5, 0.5).
+     */
+    std::vector<double> signal(std::size_t len, unsigned seed)
+    {
+        std::mt19937 gen{ seed };
+        std::uniform_real_distribution<double> dist{ -0.5, 0.5 };
+        std::vector<double> res(len);
+        for (double &d : res)
+            d = dist(gen);
+        return res;
+    }
+
+    /*
+     * Convert a signal to FixedPoint numbers, floating-point numbers or raw
+     * integers of Q-format Q(INT_BITS, FRAC_BITS).
+     */
+    template <typename T>
+    std::vector<T> convert(const std::vector<double> &sig)
+    {
+        return std::vector<T>(sig.begin(), sig.end());
+    }
+    template <int INT_BITS, int FRAC_BITS, typename T>
+    std::vector<T> to_raw(const std::vector<double> &sig)
+    {
+        std::vector<T> res{};
+        for (double d : sig)
+        {
+            res.push_back(static_cast<T>(
+                        FixedPoint<INT_BITS, FRAC_BITS>{ d }.get_raw()));
+        }
+        return res;
+    }
+    template <int INT_BITS, int FRAC_BITS>
+    std::vector<FixedPoint<INT_BITS, FRAC_BITS>>
+        to_fixed(const std::vector<double> &sig)
+    {
+        std::vector<FixedPoint<INT_BITS, FRAC_BITS>> res{};
+        for (double d : sig)
+            res.emplace_back(d);
+        return res;
+    }
+
+    /*
+     * Dot product of Q(1,15) vectors with a Q(12,30) accumulator.
+     */
+    void bench_dot(bench::Runner &runner)
+    {
+        const auto a = signal(DOT_LEN, 1), b = signal(DOT_LEN, 2);
+        const auto fa = to_fixed<1,15>(a), fb = to_fixed<1,15>(b);
+        const auto ia = to_raw<1,15,std::int16_t>(a);
+        const auto ib = to_raw<1,15,std::int16_t>(b);
+        const auto sa = convert<float>(a), sb = convert<float>(b);
+
+        run_blocks(runner, "dot", "FixedPoint", DOT_LEN, [&]
+        {
+            FixedPoint<12,30> acc{};
+            for (std::size_t i=0; i<DOT_LEN; ++i)
+                acc += fa[i] * fb[i];
+            bench::do_not_optimize(acc);
+        });
+        run_blocks(runner, "dot", "ExactFixedPoint", DOT_LEN, [&]
+        {
+            ExactFixedPoint<12,30> acc{};
+            for (std::size_t i=0; i<DOT_LEN; ++i)
+            {
+                acc += make_exact_fixed_point(fa[i]) *
+                       make_exact_fixed_point(fb[i]);
+            }
+            bench::do_not_optimize(acc);
+        });
+        run_blocks(runner, "dot", "double", DOT_LEN, [&]
+        {
+            double acc{};
+            for (std::size_t i=0; i<DOT_LEN; ++i)
+                acc += a[i] * b[i];
+            bench::do_not_optimize(acc);
+        });
+        run_blocks(runner, "dot", "float", DOT_LEN, [&]
+        {
+            float acc{};
+            for (std::size_t i=0; i<DOT_LEN; ++i)
+                acc += sa[i] * sb[i];
+            bench::do_not_optimize(acc);
+        });
+        run_blocks(runner, "dot", "int", DOT_LEN, [&]
+        {
+            long long acc{};
+            for (std::size_t i=0; i<DOT_LEN; ++i)
+                acc += static_cast<std::int32_t>(ia[i]) * ib[i];
+            bench::do_not_optimize(acc);
+        });
+    }
+
+    /*
+     * FIR filter with Q(1,15) taps and samples and a Q(8,30) accumulator.
+     */
+    template <typename T>
+    void fir_float(const std::vector<T> &h, const std::vector<T> &x,
+                   std::vector<T> &y)
+    {
+        for (std::size_t n=0; n<FIR_LEN; ++n)
+        {
+            T acc{};
+            for (std::size_t k=0; k<FIR_TAPS; ++k)
+                acc += h[k] * x[n+k];
+            y[n] = acc;
+        }
+    }
+    void bench_fir(bench::Runner &runner)
+    {
+        auto h = signal(FIR_TAPS, 3);
+        for (double &d : h)
+            d /= FIR_TAPS;
+        const auto x = signal(FIR_LEN + FIR_TAPS - 1, 4);
+        const auto fh = to_fixed<1,15>(h), fx = to_fixed<1,15>(x);
+        const auto ih = to_raw<1,15,std::int16_t>(h);
+        const auto ix = to_raw<1,15,std::int16_t>(x);
+        const auto sh = convert<float>(h), sx = convert<float>(x);
+
+        std::vector<fix_sample> fy(FIR_LEN);
+        run_blocks(runner, "fir", "FixedPoint", FIR_LEN, [&]
+        {
+            for (std::size_t n=0; n<FIR_LEN; ++n)
+            {
+                FixedPoint<8,30> acc{};
+                for (std::size_t k=0; k<FIR_TAPS; ++k)
+                    acc += fh[k] * fx[n+k];
+                fy[n] = acc;
+            }
+        });
+        std::vector<double> y(FIR_LEN);
+        run_blocks(runner, "fir", "double", FIR_LEN, [&]
+        {
+            fir_float(h, x, y);
+        });
+        std::vector<float> sy(FIR_LEN);
+        run_blocks(runner, "fir", "float", FIR_LEN, [&]
+        {
+            fir_float(sh, sx, sy);
+        });
+        std::vector<std::int16_t> iy(FIR_LEN);
+        run_blocks(runner, "fir", "int", FIR_LEN, [&]
+        {
+            for (std::size_t n=0; n<FIR_LEN; ++n)
+            {
+                long long acc{};
+                for (std::size_t k=0; k<FIR_TAPS; ++k)
+                    acc += static_cast<std::int32_t>(ih[k]) * ix[n+k];
+                iy[n] = static_cast<std::int16_t>((acc + (1 << 14)) >> 15);
+            }
+        });
+    }
+
+    /*
+     * Direct form I lowpass biquad with Q(2,14) coefficients and samples and a
+     * Q(8,28) accumulator.
+     */
+    void bench_biquad(bench::Runner &runner)
+    {
+        const double coef[5] = {
+            0.0674552738890719, 0.1349105477781438, 0.0674552738890719,
+            -1.1429805025399011, 0.4128015980961886
+        };
+        const auto x = signal(BIQUAD_LEN, 5);
+
+        {
+            const auto c = to_fixed<2,14>(
+                    std::vector<double>(coef, coef+5));
+            const auto fx = to_fixed<2,14>(x);
+            std::vector<FixedPoint<2,14>> fy(BIQUAD_LEN);
+            run_blocks(runner, "biquad", "FixedPoint", BIQUAD_LEN, [&]
+            {
+                FixedPoint<2,14> x1{}, x2{}, y1{}, y2{};
+                for (std::size_t n=0; n<BIQUAD_LEN; ++n)
+                {
+                    FixedPoint<8,28> acc{ c[0] * fx[n] };
+                    acc += c[1] * x1;
+                    acc += c[2] * x2;
+                    acc -= c[3] * y1;
+                    acc -= c[4] * y2;
+                    x2 = x1; x1 = fx[n];
+                    y2 = y1; y1 = acc;
+                    fy[n] = y1;
+                }
+            });
+        }
+        {
+            std::vector<double> y(BIQUAD_LEN);
+            run_blocks(runner, "biquad", "double", BIQUAD_LEN, [&]
+            {
+                double x1{}, x2{}, y1{}, y2{};
+                for (std::size_t n=0; n<BIQUAD_LEN; ++n)
+                {
+                    double acc = coef[0]*x[n] + coef[1]*x1 + coef[2]*x2
+                               - coef[3]*y1 - coef[4]*y2;
+                    x2 = x1; x1 = x[n];
+                    y2 = y1; y1 = acc;
+                    y[n] = y1;
+                }
+            });
+        }
+        {
+            const auto c = convert<float>(std::vector<double>(coef, coef+5));
+            const auto sx = convert<float>(x);
+            std::vector<float> y(BIQUAD_LEN);
+            run_blocks(runner, "biquad", "float", BIQUAD_LEN, [&]
+            {
+                float x1{}, x2{}, y1{}, y2{};
+                for (std::size_t n=0; n<BIQUAD_LEN; ++n)
+                {
+                    float acc = c[0]*sx[n] + c[1]*x1 + c[2]*x2
+                              - c[3]*y1 - c[4]*y2;
+                    x2 = x1; x1 = sx[n];
+                    y2 = y1; y1 = acc;
+                    y[n] = y1;
+                }
+            });
+        }
+        {
+            const auto c = to_raw<2,14,std::int32_t>(
+                    std::vector<double>(coef, coef+5));
+            const auto ix = to_raw<2,14,std::int16_t>(x);
+            std::vector<std::int16_t> y(BIQUAD_LEN);
+            run_blocks(runner, "biquad", "int", BIQUAD_LEN, [&]
+            {
+                std::int32_t x1{}, x2{}, y1{}, y2{};
+                for (std::size_t n=0; n<BIQUAD_LEN; ++n)
+                {
+                    long long acc = c[0]*ix[n] + c[1]*x1 + c[2]*x2
+                                  - c[3]*y1 - c[4]*y2;
+                    x2 = x1; x1 = ix[n];
+                    y2 = y1;
+                    y1 = static_cast<std::int16_t>((acc + (1 << 13)) >> 14);
+                    y[n] = static_cast<std::int16_t>(y1);
+                }
+            });
+        }
+    }
+
+    /*
+     * In-place iterative radix-2 decimation in time FFT of length FFT_LEN. The
+     * twiddle factors are (wr[k], wi[k]) = exp(-2*pi*i*k/FFT_LEN) and
+     * 'mul(w, v)' multiplies a twiddle factor with a value.
+     */
+    template <typename V, typename W, typename Mul>
+    void fft(V *re, V *im, const W *wr, const W *wi,
+             const std::vector<unsigned> &rev, Mul mul)
+    {
+        for (std::size_t i=0; i<FFT_LEN; ++i)
+        {
+            if (i < rev[i])
+            {
+                std::swap(re[i], re[rev[i]]);
+                std::swap(im[i], im[rev[i]]);
+            }
+        }
+        for (std::size_t len=2; len<=FFT_LEN; len<<=1)
+        {
+            std::size_t half = len/2, step = FFT_LEN/len;
+            for (std::size_t i=0; i<FFT_LEN; i+=len)
+            {
+                for (std::size_t j=0; j<half; ++j)
+                {
+                    const W &c = wr[j*step], &s = wi[j*step];
+                    V xr = re[i+j+half], xi = im[i+j+half];
+                    V tr = mul(c, xr) - mul(s, xi);
+                    V ti = mul(c, xi) + mul(s, xr);
+                    re[i+j+half] = re[i+j] - tr;
+                    im[i+j+half] = im[i+j] - ti;
+                    re[i+j] = re[i+j] + tr;
+                    im[i+j] = im[i+j] + ti;
+                }
+            }
+        }
+    }
+    template <typename V, typename W, typename Mul>
+    void bench_fft_variant(bench::Runner &runner, const std::string &format,
+                           const std::vector<V> &in_re,
+                           const std::vector<V> &in_im,
+                           const std::vector<W> &wr, const std::vector<W> &wi,
+                           const std::vector<unsigned> &rev, Mul mul)
+    {
+        std::vector<V> re(FFT_LEN), im(FFT_LEN);
+        run_blocks(runner, "fft256", format, 1, [&]
+        {
+            std::copy(in_re.begin(), in_re.end(), re.begin());
+            std::copy(in_im.begin(), in_im.end(), im.begin());
+            fft(re.data(), im.data(), wr.data(), wi.data(), rev, mul);
+        });
+    }
+    void bench_fft(bench::Runner &runner)
+    {
+        const auto re = signal(FFT_LEN, 6), im = signal(FFT_LEN, 7);
+        std::vector<double> wr(FFT_LEN/2), wi(FFT_LEN/2);
+        for (std::size_t k=0; k<FFT_LEN/2; ++k)
+        {
+            wr[k] =  std::cos(2*PI*static_cast<double>(k)/FFT_LEN);
+            wi[k] = -std::sin(2*PI*static_cast<double>(k)/FFT_LEN);
+        }
+        std::vector<unsigned> rev(FFT_LEN);
+        for (unsigned i=0; i<FFT_LEN; ++i)
+        {
+            for (unsigned b=1; b<FFT_LEN; b<<=1)
+                rev[i] = (rev[i] << 1) | ((i & b) ? 1 : 0);
+        }
+
+        /*
+         * Values in Q(12,20), growth of at most 2^8 for 256 points, and
+         * twiddle factors in Q(2,30).
+         */
+        using fix_val = FixedPoint<12,20>;
+        using fix_tw  = FixedPoint<2,30>;
+        bench_fft_variant(runner, "FixedPoint",
+                to_fixed<12,20>(re), to_fixed<12,20>(im),
+                to_fixed<2,30>(wr), to_fixed<2,30>(wi), rev,
+                [](const fix_tw &w, const fix_val &v)
+                {
+                    return fix_val{ w*v };
+                });
+        bench_fft_variant(runner, "double", re, im, wr, wi, rev,
+                [](double w, double v) { return w*v; });
+        bench_fft_variant(runner, "float",
+                convert<float>(re), convert<float>(im),
+                convert<float>(wr), convert<float>(wi), rev,
+                [](float w, float v) { return w*v; });
+        bench_fft_variant(runner, "int",
+                to_raw<12,20,std::int32_t>(re), to_raw<12,20,std::int32_t>(im),
+                to_raw<2,30,std::int32_t>(wr), to_raw<2,30,std::int32_t>(wi),
+                rev, [](std::int32_t w, std::int32_t v)
+                {
+                    return static_cast<std::int32_t>(
+                            (static_cast<long long>(w) * v + (1 << 29)) >> 30);
+                });
+    }
+
+    /*
+     * The Leibniz formula loop of tests/test.cc, 'LOOP_ITERATIONS' iterations
+     * per block.
+     */
+    template <typename T>
+    T leibniz_float()
+    {
+        T pi{ 4 }, divisor{ 3 };
+        for (std::size_t i=0; i<LOOP_ITERATIONS; ++i)
+        {
+            if (i % 2)
+                pi += T{ 4 } / divisor;
+            else
+                pi -= T{ 4 } / divisor;
+            divisor += T{ 2 };
+        }
+        return pi;
+    }
+    void bench_leibniz(bench::Runner &runner)
+    {
+        run_blocks(runner, "leibniz", "FixedPoint", LOOP_ITERATIONS, [&]
+        {
+            FixedPoint<4,32> pi_fixed{ 4.0_fxp };
+            FixedPoint<32,0> divisor{ 3.0_fxp };
+            for (std::size_t i=0; i<LOOP_ITERATIONS; ++i)
+            {
+                if (i % 2)
+                    pi_fixed += FixedPoint<4,32>{4.0_fxp}/divisor;
+                else
+                    pi_fixed -= FixedPoint<4,32>{4.0_fxp}/divisor;
+                divisor += FixedPoint<3,0>{2_fxp};
+            }
+            bench::do_not_optimize(pi_fixed);
+        });
+        run_blocks(runner, "leibniz", "double", LOOP_ITERATIONS, [&]
+        {
+            bench::do_not_optimize(leibniz_float<double>());
+        });
+        run_blocks(runner, "leibniz", "float", LOOP_ITERATIONS, [&]
+        {
+            bench::do_not_optimize(leibniz_float<float>());
+        });
+        run_blocks(runner, "leibniz", "int", LOOP_ITERATIONS, [&]
+        {
+            // Q(4,32) result, integer divisor.
+            long long pi{ 4ll << 32 }, divisor{ 3 };
+            for (std::size_t i=0; i<LOOP_ITERATIONS; ++i)
+            {
+                if (i % 2)
+                    pi += (4ll << 32) / divisor;
+                else
+                    pi -= (4ll << 32) / divisor;
+                divisor += 2;
+            }
+            bench::do_not_optimize(pi);
+        });
+    }
+
+    /*
+     * The Bernoulli limit loop of tests/test.cc, 'LOOP_ITERATIONS' iterations
+     * per block.
+     */
+    void bench_bernoulli(bench::Runner &runner)
+    {
+        const double factor{ 1.0 + 1.0/99500.0 };
+        run_blocks(runner, "bernoulli", "FixedPoint", LOOP_ITERATIONS, [&]
+        {
+            const FixedPoint<3,32> product_fixed{ factor };
+            FixedPoint<3,32> e_fixed{ 1.0 };
+            for (std::size_t i=0; i<LOOP_ITERATIONS; ++i)
+                e_fixed *= product_fixed;
+            bench::do_not_optimize(e_fixed);
+        });
+        run_blocks(runner, "bernoulli", "double", LOOP_ITERATIONS, [&]
+        {
+            double e{ 1.0 };
+            for (std::size_t i=0; i<LOOP_ITERATIONS; ++i)
+                e *= factor;
+            bench::do_not_optimize(e);
+        });
+        run_blocks(runner, "bernoulli", "float", LOOP_ITERATIONS, [&]
+        {
+            const float product{ static_cast<float>(factor) };
+            float e{ 1.0f };
+            for (std::size_t i=0; i<LOOP_ITERATIONS; ++i)
+                e *= product;
+            bench::do_not_optimize(e);
+        });
+        run_blocks(runner, "bernoulli", "int", LOOP_ITERATIONS, [&]
+        {
+            // Q(3,32) numbers, 128-bit product truncated towards -INF.
+            const long long product{ FixedPoint<3,32>{ factor }.get_raw() };
+            long long e{ 1ll << 32 };
+            for (std::size_t i=0; i<LOOP_ITERATIONS; ++i)
+            {
+                e = static_cast<long long>(
+                        (static_cast<int128>(e) * product) >> 32);
+            }
+            bench::do_not_optimize(e);
+        });
+    }
+
+    /*
+     * Multiplication of Q(1,15) matrices with a Q(12,30) accumulator and a
+     * Q(8,15) result.
+     */
+    template <typename T>
+    void matmul_float(const std::vector<T> &a, const std::vector<T> &b,
+                      std::vector<T> &c)
+    {
+        for (std::size_t i=0; i<MAT_DIM; ++i)
+        {
+            for (std::size_t j=0; j<MAT_DIM; ++j)
+            {
+                T acc{};
+                for (std::size_t k=0; k<MAT_DIM; ++k)
+                    acc += a[i*MAT_DIM + k] * b[k*MAT_DIM + j];
+                c[i*MAT_DIM + j] = acc;
+            }
+        }
+    }
+    void bench_matmul(bench::Runner &runner)
+    {
+        constexpr std::size_t MACS = MAT_DIM * MAT_DIM * MAT_DIM;
+        const auto a = signal(MAT_DIM * MAT_DIM, 8);
+        const auto b = signal(MAT_DIM * MAT_DIM, 9);
+        const auto fa = to_fixed<1,15>(a), fb = to_fixed<1,15>(b);
+        const auto ia = to_raw<1,15,std::int16_t>(a);
+        const auto ib = to_raw<1,15,std::int16_t>(b);
+        const auto sa = convert<float>(a), sb = convert<float>(b);
+
+        std::vector<FixedPoint<8,15>> fc(MAT_DIM * MAT_DIM);
+        run_blocks(runner, "matmul", "FixedPoint", MACS, [&]
+        {
+            for (std::size_t i=0; i<MAT_DIM; ++i)
+            {
+                for (std::size_t j=0; j<MAT_DIM; ++j)
+                {
+                    FixedPoint<12,30> acc{};
+                    for (std::size_t k=0; k<MAT_DIM; ++k)
+                        acc += fa[i*MAT_DIM + k] * fb[k*MAT_DIM + j];
+                    fc[i*MAT_DIM + j] = acc;
+                }
+            }
+        });
+        std::vector<double> c(MAT_DIM * MAT_DIM);
+        run_blocks(runner, "matmul", "double", MACS, [&]
+        {
+            matmul_float(a, b, c);
+        });
+        std::vector<float> sc(MAT_DIM * MAT_DIM);
+        run_blocks(runner, "matmul", "float", MACS, [&]
+        {
+            matmul_float(sa, sb, sc);
+        });
+        std::vector<std::int32_t> ic(MAT_DIM * MAT_DIM);
+        run_blocks(runner, "matmul", "int", MACS, [&]
+        {
+            for (std::size_t i=0; i<MAT_DIM; ++i)
+            {
+                for (std::size_t j=0; j<MAT_DIM; ++j)
+                {
+                    long long acc{};
+                    for (std::size_t k=0; k<MAT_DIM; ++k)
+                    {
+                        acc += static_cast<std::int32_t>(ia[i*MAT_DIM + k])
+                             * ib[k*MAT_DIM + j];
+                    }
+                    ic[i*MAT_DIM + j] =
+                        static_cast<std::int32_t>((acc + (1 << 14)) >> 15);
+                }
+            }
+        });
+    }
+}
+
+void bench_kernels(bench::Runner &runner)
+{
+    bench_dot(runner);
+    bench_fir(runner);
+    bench_biquad(runner);
+    bench_fft(runner);
+    bench_leibniz(runner);
+    bench_bernoulli(runner);
+    bench_matmul(runner);
+}
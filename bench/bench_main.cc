@@ -0,0 +1,22 @@
+/*
+ * PoorMansFixedPoint benchmark executable. Runs the per-operator benchmarks of
+ * bench_ops.cc followed by the application kernel benchmarks of
+ * bench_kernels.cc.
+ *
+ * Build and run with 'make bench', see bench.h for command line options, e.g,
+ *
+ *     make bench BENCH_ARGS="--filter fir --json results.json"
+ */
+
+#include "bench.h"
+
+void bench_ops(bench::Runner &runner);
+void bench_kernels(bench::Runner &runner);
+
+int main(int argc, char **argv)
+{
+    bench::Runner runner{ argc, argv };
+    bench_ops(runner);
+    bench_kernels(runner);
+    return runner.finish();
+}
@@ -0,0 +1,201 @@
+/*
+ * Per-operator micro-benchmarks of FixedPoint.h. Every operator is timed over
+ * arrays of random operands for a matrix of formats chosen to hit each of the
+ * internal code paths, e.g, multiplication scenario 1 and scenario 2.
+ */
+
+#include "bench.h"
+#include "FixedPoint.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+    /*
+     * Number of operands in each operand array, small enough to stay in L1.
+     */
+    constexpr std::size_t N = 1024;
+
+    template <int INT_BITS, int FRAC_BITS>
+    std::string q()
+    {
+        return "Q(" + std::to_string(INT_BITS) + ","
+                    + std::to_string(FRAC_BITS) + ")";
+    }
+
+    /*
+     * Array of N uniformly distributed random FixedPoint numbers in [lo, hi).
+     */
+    template <int INT_BITS, int FRAC_BITS>
+    std::vector<FixedPoint<INT_BITS, FRAC_BITS>>
+        operands(double lo, double hi, unsigned seed)
+    {
+        std::mt19937 gen{ seed };
+        std::uniform_real_distribution<double> dist{ lo, hi };
+        std::vector<FixedPoint<INT_BITS, FRAC_BITS>> res{};
+        for (std::size_t i=0; i<N; ++i)
+            res.emplace_back(dist(gen));
+        return res;
+    }
+
+    /*
+     * Time 'out[i] = op(a[i], b[i])' over the operand arrays.
+     */
+    template <typename A, typename B, typename Op>
+    void bench_binary(bench::Runner &runner, const std::string &name,
+                      const std::string &format, const std::vector<A> &a,
+                      const std::vector<B> &b, Op op)
+    {
+        using R = decltype(op(a[0], b[0]));
+        R out[N]{};
+        runner.run(name, format, [&](std::size_t ops)
+        {
+            for (std::size_t done=0; done<ops; done+=N)
+            {
+                std::size_t len = std::min(N, ops - done);
+                for (std::size_t i=0; i<len; ++i)
+                    out[i] = op(a[i], b[i]);
+                bench::do_not_optimize(&out[0]);
+                bench::clobber_memory();
+            }
+        });
+    }
+
+    /*
+     * Time 'out[i] = op(a[i])' over the operand array.
+     */
+    template <typename A, typename Op>
+    void bench_unary(bench::Runner &runner, const std::string &name,
+                     const std::string &format, const std::vector<A> &a,
+                     Op op)
+    {
+        using R = decltype(op(a[0]));
+        R out[N]{};
+        runner.run(name, format, [&](std::size_t ops)
+        {
+            for (std::size_t done=0; done<ops; done+=N)
+            {
+                std::size_t len = std::min(N, ops - done);
+                for (std::size_t i=0; i<len; ++i)
+                    out[i] = op(a[i]);
+                bench::do_not_optimize(&out[0]);
+                bench::clobber_memory();
+            }
+        });
+    }
+}
+
+void bench_ops(bench::Runner &runner)
+{
+    auto add = [](const auto &a, const auto &b) { return a + b; };
+    auto sub = [](const auto &a, const auto &b) { return a - b; };
+    auto mul = [](const auto &a, const auto &b) { return a * b; };
+    auto div = [](const auto &a, const auto &b) { return a / b; };
+    auto eq  = [](const auto &a, const auto &b) { return a == b; };
+    auto lt  = [](const auto &a, const auto &b) { return a < b; };
+
+    const auto a_8_8   = operands<8,8>(-10.0, 10.0, 1);
+    const auto b_8_8   = operands<8,8>(0.5, 4.0, 2);
+    const auto a_10_10 = operands<10,10>(-100.0, 100.0, 3);
+    const auto b_10_10 = operands<10,10>(-100.0, 100.0, 4);
+    const auto a_9_10  = operands<9,10>(-100.0, 100.0, 5);
+    const auto b_6_12  = operands<6,12>(-10.0, 10.0, 6);
+    const auto a_1_30  = operands<1,30>(-1.0, 1.0, 7);
+    const auto b_1_30  = operands<1,30>(-1.0, 1.0, 8);
+    const auto a_3_30  = operands<3,30>(-4.0, 4.0, 9);
+    const auto a_25_21 = operands<25,21>(-1000.0, 1000.0, 10);
+    const auto b_20_21 = operands<20,21>(-1000.0, 1000.0, 11);
+    const auto a_13_22 = operands<13,22>(-100.0, 100.0, 12);
+    const auto b_14_17 = operands<14,17>(0.5, 100.0, 13);
+    const auto a_14_14 = operands<14,14>(-500.0, 500.0, 14);
+    const auto b_20_23 = operands<20,23>(-100.0, 100.0, 15);
+    const auto a_32_32 = operands<32,32>(-1e6, 1e6, 16);
+    const auto b_32_32 = operands<32,32>(-1e6, 1e6, 17);
+
+    /*
+     * Addition and subtraction.
+     */
+    bench_binary(runner, "add", q<10,10>() + "+" + q<10,10>(),
+                 a_10_10, b_10_10, add);
+    bench_binary(runner, "add", q<9,10>() + "+" + q<6,12>(),
+                 a_9_10, b_6_12, add);
+    bench_binary(runner, "add", q<32,32>() + "+" + q<32,32>(),
+                 a_32_32, b_32_32, add);
+    bench_binary(runner, "sub", q<10,10>() + "-" + q<10,10>(),
+                 a_10_10, b_10_10, sub);
+    bench_unary(runner, "neg", q<10,10>(), a_10_10,
+                [](const FixedPoint<10,10> &a) { return -a; });
+
+    /*
+     * Multiplication, scenario 1 (operands have no more than 64 significant
+     * bits in total) and scenario 2.
+     */
+    bench_binary(runner, "mul_scenario1", q<8,8>() + "*" + q<8,8>(),
+                 a_8_8, b_8_8, mul);
+    bench_binary(runner, "mul_scenario1", q<1,30>() + "*" + q<1,30>(),
+                 a_1_30, b_1_30, mul);
+    bench_binary(runner, "mul_scenario1", q<3,30>() + "*" + q<1,30>(),
+                 a_3_30, b_1_30, mul);
+    bench_binary(runner, "mul_scenario2", q<25,21>() + "*" + q<20,21>(),
+                 a_25_21, b_20_21, mul);
+    bench_unary(runner, "mul_const", q<8,8>() + "*" + q<1,15>(), a_8_8,
+                [](const FixedPoint<8,8> &a)
+                { return mul_const<1,15,0x2400>(a); });
+    bench_binary(runner, "mul_assign", q<1,30>() + "*=" + q<1,30>(),
+                 a_1_30, b_1_30,
+                 [](FixedPoint<1,30> a, const FixedPoint<1,30> &b)
+                 { return a *= b; });
+
+    /*
+     * Division.
+     */
+    bench_binary(runner, "div", q<8,8>() + "/" + q<8,8>(),
+                 a_8_8, b_8_8, div);
+    bench_binary(runner, "div", q<13,22>() + "/" + q<14,17>(),
+                 a_13_22, b_14_17, div);
+
+    /*
+     * Scaling by integers and powers of two.
+     */
+    bench_unary(runner, "mul_int", q<10,10>() + "*3", a_10_10,
+                [](const FixedPoint<10,10> &a) { return a * 3; });
+    bench_unary(runner, "div_int", q<10,10>() + "/3", a_10_10,
+                [](const FixedPoint<10,10> &a) { return a / 3; });
+    bench_unary(runner, "shift", q<10,10>() + ">>3", a_10_10,
+                [](const FixedPoint<10,10> &a) { return a >> 3; });
+
+    /*
+     * Comparison.
+     */
+    bench_binary(runner, "eq", q<10,10>() + "==" + q<20,23>(),
+                 a_10_10, b_20_23, eq);
+    bench_binary(runner, "lt", q<10,10>() + "<" + q<10,10>(),
+                 a_10_10, b_10_10, lt);
+
+    /*
+     * Conversions.
+     */
+    std::vector<double> doubles(N);
+    std::vector<int> ints(N);
+    for (std::size_t i=0; i<N; ++i)
+    {
+        doubles[i] = static_cast<double>(a_10_10[i]);
+        ints[i] = static_cast<int>(doubles[i]);
+    }
+    bench_unary(runner, "from_double", q<10,10>(), doubles,
+                [](double d) { return FixedPoint<10,10>{ d }; });
+    bench_unary(runner, "from_int", q<10,10>(), ints,
+                [](int n) { return FixedPoint<10,10>{ n }; });
+    bench_unary(runner, "to_double", q<10,10>(), a_10_10,
+                [](const FixedPoint<10,10> &a)
+                { return static_cast<double>(a); });
+    bench_unary(runner, "widen", q<10,10>() + "->" + q<14,14>(), a_10_10,
+                [](const FixedPoint<10,10> &a)
+                { return FixedPoint<14,14>{ a }; });
+    bench_unary(runner, "narrow", q<14,14>() + "->" + q<10,10>(), a_14_14,
+                [](const FixedPoint<14,14> &a)
+                { return FixedPoint<10,10>{ a }; });
+    bench_unary(runner, "to_string", q<10,10>(), a_10_10,
+                [](const FixedPoint<10,10> &a) { return a.to_string(); });
+}
@@ -0,0 +1,85 @@
+#!/bin/sh
+#
+# Verify the CODEGEN annotations of a probe source file against the
+# disassembly of its object file, see probes.cc for the annotation syntax.
+#
+# Usage: check.sh <probes.cc> <probes.o>
+#
+
+src=$1
+obj=$2
+
+if [ "$(uname -m)" != "x86_64" ]; then
+    echo "Codegen checks skipped, they are written for x86-64."
+    exit 0
+fi
+if ! command -v objdump > /dev/null; then
+    echo "Codegen checks need objdump."
+    exit 1
+fi
+
+dis=$(mktemp)
+checks=$(mktemp)
+trap 'rm -f "$dis" "$checks"' EXIT
+objdump -d -r --no-show-raw-insn "$obj" > "$dis" || exit 1
+grep '^// CODEGEN: ' "$src" | sed 's|^// ||' > "$checks"
+
+#
+# Print the instructions of function $1, one per line, together with their
+# relocations but without alignment padding.
+#
+insns()
+{
+    awk -v fn="<$1>:" '
+        $2 == fn          { infn = 1; next }
+        !infn             { next }
+        /^[0-9a-f]+ </    { exit }
+        /^$/              { exit }
+        {
+            sub(/^[ \t]*[0-9a-f]+:[ \t]*/, "")
+            if ($0 !~ /^(nop|data16|cs nop|xchg +%ax,%ax)/)
+                print
+        }
+    ' "$dis"
+}
+
+failures=0
+total=0
+while read -r _ fn check arg; do
+    total=$((total + 1))
+    body=$(insns "$fn")
+    if [ -z "$body" ]; then
+        echo "FAILED: $fn not found in $obj"
+        failures=$((failures + 1))
+        continue
+    fi
+    count=$(printf '%s\n' "$body" | grep -vc 'R_X86_64')
+    case $check in
+        max-insns)
+            ok=$([ "$count" -le "$arg" ] && echo 1)
+            what="$count instructions, limit $arg" ;;
+        no-call)
+            ok=$(printf '%s\n' "$body" | grep -q '^call' || echo 1)
+            what="calls present" ;;
+        no-call-to)
+            ok=$(printf '%s\n' "$body" | grep -q "R_X86_64.*$arg" || echo 1)
+            what="calls $arg" ;;
+        vectorized)
+            ok=$(printf '%s\n' "$body" \
+                | grep -Eq '^(v?p[a-z0-9]+|v?[a-z]+p[sd]) .*%[xyz]mm' && echo 1)
+            what="no packed SIMD instructions" ;;
+        *)
+            ok=""
+            what="unknown check '$check'" ;;
+    esac
+    if [ -z "$ok" ]; then
+        echo "FAILED: $fn $check $arg ($what)"
+        failures=$((failures + 1))
+    fi
+done < "$checks"
+
+if [ "$failures" -ne 0 ]; then
+    echo "$failures of $total codegen checks failed."
+    exit 1
+fi
+echo "All codegen checks passed ($total checks)."
@@ -0,0 +1,227 @@
+/*
+ * Codegen probes. Small functions exercising the hot paths of FixedPoint.h,
+ * compiled with the project flags and disassembled by check.sh, which verifies
+ * the expectations given by the CODEGEN annotations below.
+ *
+ * Annotation syntax, one check per line:
+ *
+ *   // CODEGEN: <function> max-insns <n>      At most <n> instructions.
+ *   // CODEGEN: <function> no-call            No call instructions at all.
+ *   // CODEGEN: <function> no-call-to <sym>   No call to symbol <sym>.
+ *   // CODEGEN: <function> vectorized         Packed SIMD instructions present.
+ *
+ * The limits describe the code generated by GCC for x86-64 at the time of
+ * writing, with some slack. A failing check means that the optimizer stopped
+ * folding, inlining or vectorizing something it used to.
+ */
+
+#include "FixedPoint.h"
+#include "FixedPointRanged.h"
+#include "FixedPointAtomic.h"
+#include "FixedPointReduce.h"
+#include <cstdint>
+
+extern "C"
+{
+
+/*
+ * Same-format addition.
+ */
+// CODEGEN: probe_add_same max-insns 8
+// CODEGEN: probe_add_same no-call
+void probe_add_same(FixedPoint<10,10> *out, const FixedPoint<10,10> *a,
+                    const FixedPoint<10,10> *b)
+{
+    *out = *a + *b;
+}
+
+/*
+ * Addition with 32 fractional bits, where the rounding branch folds away.
+ */
+// CODEGEN: probe_add_frac32 max-insns 8
+// CODEGEN: probe_add_frac32 no-call
+void probe_add_frac32(FixedPoint<4,32> *out, const FixedPoint<4,32> *a,
+                      const FixedPoint<4,32> *b)
+{
+    *out = *a + *b;
+}
+
+/*
+ * Multiplication, scenario 1.
+ */
+// CODEGEN: probe_mul_scenario1 max-insns 10
+// CODEGEN: probe_mul_scenario1 no-call
+void probe_mul_scenario1(FixedPoint<16,16> *out, const FixedPoint<8,8> *a,
+                         const FixedPoint<8,8> *b)
+{
+    *out = *a * *b;
+}
+
+/*
+ * Multiplication, scenario 1, with operands wider than 32 bits.
+ */
+// CODEGEN: probe_mul_scenario1_wide max-insns 10
+// CODEGEN: probe_mul_scenario1_wide no-call
+void probe_mul_scenario1_wide(FixedPoint<4,32> *out, const FixedPoint<3,30> *a,
+                              const FixedPoint<1,30> *b)
+{
+    *out = *a * *b;
+}
+
+/*
+ * Multiplication, scenario 2. The 128-bit product must be inlined.
+ */
+// CODEGEN: probe_mul_scenario2 max-insns 7
+// CODEGEN: probe_mul_scenario2 no-call-to __multi3
+void probe_mul_scenario2(FixedPoint<32,32> *out, const FixedPoint<25,21> *a,
+                         const FixedPoint<20,21> *b)
+{
+    *out = *a * *b;
+}
+
+/*
+ * Literals are rounded at compile time, leaving a constant store.
+ */
+// CODEGEN: probe_literal max-insns 3
+// CODEGEN: probe_literal no-call
+void probe_literal(FixedPoint<4,28> *out)
+{
+    *out = -1.2345e-2_fxp;
+}
+
+/*
+ * Scaling by integers and powers of two. Multiplication by an integer is a
+ * single multiply, and division by a constant integer needs no call to the
+ * 128-bit division routine.
+ */
+// CODEGEN: probe_mul_int max-insns 5
+// CODEGEN: probe_mul_int no-call
+void probe_mul_int(FixedPoint<32,12> *out, const FixedPoint<1,12> *a, int n)
+{
+    *out = *a * n;
+}
+// CODEGEN: probe_div_int max-insns 22
+// CODEGEN: probe_div_int no-call
+void probe_div_int(FixedPoint<8,12> *out, const FixedPoint<8,12> *a)
+{
+    *out = *a / 3;
+}
+// CODEGEN: probe_shift_right max-insns 10
+// CODEGEN: probe_shift_right no-call
+void probe_shift_right(FixedPoint<8,12> *out, const FixedPoint<8,12> *a,
+                       int n)
+{
+    *out = *a >> n;
+}
+// CODEGEN: probe_mul_pow2 max-insns 9
+// CODEGEN: probe_mul_pow2 no-call
+void probe_mul_pow2(FixedPoint<8,12> *out, const FixedPoint<8,12> *a)
+{
+    *out = a->mul_pow2<-3>();
+}
+
+/*
+ * Multiplication by a constant with two non-zero CSD digits, 0.28125 =
+ * 2^-2 + 2^-5, by shifts and additions.
+ */
+// CODEGEN: probe_mul_const max-insns 7
+// CODEGEN: probe_mul_const no-call
+void probe_mul_const(FixedPoint<2,30> *out, const FixedPoint<1,15> *a)
+{
+    *out = mul_const<1,15,0x2400>(*a);
+}
+
+/*
+ * Atomic addition with rounding, a single locked addition and no
+ * compare-and-swap loop.
+ */
+// CODEGEN: probe_atomic_fetch_add max-insns 7
+// CODEGEN: probe_atomic_fetch_add no-call
+void probe_atomic_fetch_add(AtomicFixedPoint<8,12> *acc,
+                            const FixedPoint<4,20> *a)
+{
+    acc->fetch_add(*a, std::memory_order_relaxed);
+}
+
+/*
+ * Widening conversion, which is exact and reduces to a plain copy.
+ */
+// CODEGEN: probe_widen max-insns 4
+// CODEGEN: probe_widen no-call
+void probe_widen(FixedPoint<14,14> *out, const FixedPoint<10,10> *a)
+{
+    *out = *a;
+}
+
+/*
+ * Comparison between different formats.
+ */
+// CODEGEN: probe_compare max-insns 6
+// CODEGEN: probe_compare no-call
+bool probe_compare(const FixedPoint<10,10> *a, const FixedPoint<20,23> *b)
+{
+    return *a == *b;
+}
+
+/*
+ * Element-wise addition over integer buffers, through FixedPointSpan.
+ */
+// CODEGEN: probe_span_add_loop vectorized
+// CODEGEN: probe_span_add_loop no-call
+void probe_span_add_loop(std::int32_t *__restrict out,
+                         const std::int32_t *__restrict a,
+                         const std::int32_t *__restrict b)
+{
+    FixedPointSpan<8,24,std::int32_t> res{ out, 1024 };
+    FixedPointSpan<8,24,const std::int32_t> lhs{ a, 1024 }, rhs{ b, 1024 };
+    for (std::size_t i=0; i<1024; ++i)
+        res.set(i, lhs.get(i) + rhs.get(i));
+}
+
+/*
+ * Chunk kernels of the parallel reductions, which must stay vectorized.
+ */
+// CODEGEN: probe_reduce_sum vectorized
+// CODEGEN: probe_reduce_sum no-call
+unsigned long long probe_reduce_sum(const std::int16_t *a, std::size_t n)
+{
+    return fixed_point_detail::raw_sum<16>(a, 0, n);
+}
+// The only calls are those throwing on spans of different lengths.
+// CODEGEN: probe_reduce_dot vectorized
+void probe_reduce_dot(FixedPoint<32,30> *out, const std::int16_t *a,
+                      const std::int16_t *b, std::size_t n)
+{
+    FixedPointSpan<1,15,const std::int16_t> x{ a, n }, y{ b, n };
+    *out = fixed_point_dot(x, y);
+}
+
+/*
+ * Saturation of y = x*c + x with a constant c. With x in [-0.5, 0.5], the
+ * interval of y proves both clamps dead, and they are removed. With the full
+ * range of x they remain.
+ */
+// CODEGEN: probe_ranged_saturate_dead max-insns 15
+// CODEGEN: probe_ranged_saturate_dead no-call
+void probe_ranged_saturate_dead(FixedPoint<1,15> *out,
+                                const FixedPoint<1,15> *x)
+{
+    FixedPoint<1,15> coeff{};
+    coeff.set_raw(9830);
+    auto c = assume_fixed_point_range<9830, 9830>(coeff);
+    auto rx = assume_fixed_point_range<-16384, 16384>(*x);
+    *out = (rx * c + rx).saturate_to<1,15>();
+}
+// CODEGEN: probe_ranged_saturate_live max-insns 21
+// CODEGEN: probe_ranged_saturate_live no-call
+void probe_ranged_saturate_live(FixedPoint<1,15> *out,
+                                const FixedPoint<1,15> *x)
+{
+    FixedPoint<1,15> coeff{};
+    coeff.set_raw(9830);
+    auto c = assume_fixed_point_range<9830, 9830>(coeff);
+    auto rx = make_ranged_fixed_point(*x);
+    *out = (rx * c + rx).saturate_to<1,15>();
+}
+
+}
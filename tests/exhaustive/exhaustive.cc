@@ -0,0 +1,406 @@
+/*
+ * Exhaustive verification of the FixedPoint.h operators. For a matrix of
+ * small formats, with operands of up to 12 bits each, every operator is
+ * evaluated for every pair of operands and compared against an exact
+ * reference. This catches rounding corner cases that random spot checks
+ * miss, and is meant to be run before adopting any new, faster, kernel:
+ * add it to verify_pair() below.
+ *
+ * The reference computes with exact rationals num/den, where den is a power
+ * of two for everything but division, in 128-bit integers. For the formats
+ * below, no intermediate value is wider than 100 bits, so the reference is
+ * exact. Results are quantized with the documented FixedPoint semantics:
+ * rounding to nearest with ties upwards, or towards -INF for results with 32
+ * fractional bits, and two's complement wrap around on overflow.
+ *
+ * The operand space of every check is split into chunks of rows which are
+ * processed by all hardware threads. Build and run with
+ * 'make exhaustive_test', or run 'tests/exhaustive/exhaustive.out <filter>'
+ * to only run checks containing <filter>.
+ */
+
+#include "FixedPoint.h"
+#include "FixedPointExact.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <algorithm>
+
+namespace
+{
+    __extension__ typedef __int128 int_128;
+
+    /*
+     * Floor of n/d for d > 0.
+     */
+    int_128 floor_div(int_128 n, int_128 d)
+    {
+        int_128 q = n / d;
+        return (n % d != 0 && n < 0) ? q - 1 : q;
+    }
+
+    /*
+     * Quantize exact value num/den, den > 0, to format <int_bits, frac_bits>
+     * and return the raw result.
+     */
+    long long quantize(int_128 num, int_128 den, int int_bits, int frac_bits)
+    {
+        int_128 raw;
+        if (frac_bits < 32)
+        {
+            // floor(num/den * 2^frac_bits + 1/2).
+            raw = floor_div(num * (int_128{ 1 } << (frac_bits+1)) + den,
+                            2 * den);
+        }
+        else
+        {
+            raw = floor_div(num * (int_128{ 1 } << 32), den);
+        }
+
+        // Two's complement wrap around to int_bits+frac_bits bits.
+        int bits = int_bits + frac_bits;
+        using uns_ll = unsigned long long;
+        uns_ll pattern = static_cast<uns_ll>(raw);
+        if (bits < 64)
+        {
+            pattern <<= 64 - bits;
+            return static_cast<long long>(pattern) >> (64 - bits);
+        }
+        return static_cast<long long>(pattern);
+    }
+
+    /*
+     * Runs checks over the operand space on all hardware threads.
+     */
+    class Harness
+    {
+    public:
+        explicit Harness(const std::string &filter)
+            : filter{ filter },
+              threads{ std::max(1u, std::thread::hardware_concurrency()) } {}
+
+        /*
+         * Run 'check(ra, rb)' for every raw operand 'ra' of 'bits_a' bits and
+         * every raw operand 'rb' of 'bits_b' bits, or only rb = 0 if 'bits_b'
+         * is zero. The check returns false on mismatch.
+         */
+        template <typename Check>
+        void run(const std::string &name, int bits_a, int bits_b,
+                 Check check)
+        {
+            if (name.find(this->filter) == std::string::npos)
+                return;
+
+            const long long lo_a = -(1ll << (bits_a-1));
+            const long long lo_b = bits_b ? -(1ll << (bits_b-1)) : 0;
+            const long long n_a = 1ll << bits_a;
+            const long long n_b = bits_b ? 1ll << bits_b : 1;
+            const long long rows_per_chunk =
+                std::max(1ll, (1ll << 16) / n_b);
+
+            std::atomic<long long> next_row{ 0 };
+            std::atomic<unsigned long long> mismatches{ 0 };
+            std::mutex mutex{};
+            long long first_a{}, first_b{};
+            bool found = false;
+
+            auto worker = [&]
+            {
+                for (;;)
+                {
+                    long long row = next_row.fetch_add(rows_per_chunk);
+                    if (row >= n_a)
+                        return;
+                    long long end = std::min(row + rows_per_chunk, n_a);
+                    unsigned long long local = 0;
+                    for (long long i=row; i<end; ++i)
+                    {
+                        for (long long j=0; j<n_b; ++j)
+                        {
+                            if (check(lo_a + i, lo_b + j))
+                                continue;
+                            if (local++ == 0)
+                            {
+                                std::lock_guard<std::mutex> lock{ mutex };
+                                if (!found || i < first_a - lo_a ||
+                                    (i == first_a - lo_a &&
+                                     j < first_b - lo_b))
+                                {
+                                    first_a = lo_a + i;
+                                    first_b = lo_b + j;
+                                    found = true;
+                                }
+                            }
+                        }
+                    }
+                    mismatches += local;
+                }
+            };
+            std::vector<std::thread> pool{};
+            for (unsigned t=1; t<this->threads; ++t)
+                pool.emplace_back(worker);
+            worker();
+            for (std::thread &t : pool)
+                t.join();
+
+            ++this->checks;
+            std::cout << "    " << name << ": "
+                      << n_a * n_b << " cases, ";
+            if (mismatches)
+            {
+                ++this->failures;
+                std::cout << mismatches << " MISMATCHES, first for raw "
+                          << "operands " << first_a
+                          << (bits_b ? ", " + std::to_string(first_b) : "")
+                          << std::endl;
+            }
+            else
+            {
+                std::cout << "ok" << std::endl;
+            }
+        }
+
+        int finish() const
+        {
+            std::cout << (this->failures ? "FAILED: " : "Passed: ")
+                      << this->checks - this->failures << " of "
+                      << this->checks << " exhaustive checks passed."
+                      << std::endl;
+            return this->failures ? 1 : 0;
+        }
+
+    private:
+        std::string filter;
+        unsigned threads;
+        int checks{};
+        int failures{};
+    };
+
+    template <int INT_BITS, int FRAC_BITS>
+    FixedPoint<INT_BITS, FRAC_BITS> from_raw(long long raw)
+    {
+        FixedPoint<INT_BITS, FRAC_BITS> res{};
+        res.set_raw(raw);
+        return res;
+    }
+
+    template <int INT_BITS, int FRAC_BITS>
+    std::string q()
+    {
+        return "Q(" + std::to_string(INT_BITS) + ","
+                    + std::to_string(FRAC_BITS) + ")";
+    }
+
+    /*
+     * Check every operator for operand formats A = Q(IA,FA) and B = Q(IB,FB).
+     */
+    template <int IA, int FA, int IB, int FB>
+    void verify_pair(Harness &h)
+    {
+        static_assert(FA >= 0 && FB >= 0 && IA+FA <= 12 && IB+FB <= 12,
+                "Exhaustive checks are limited to small formats.");
+        using A = FixedPoint<IA,FA>;
+        using B = FixedPoint<IB,FB>;
+        using P = decltype(A{} * B{});
+        constexpr int BITS_A = IA + FA;
+        constexpr int BITS_B = IB + FB;
+        const int IP = P{}.get_int_bits();
+        const int FP = P{}.get_frac_bits();
+        const std::string fa = q<IA,FA>();
+        const std::string fab = fa + " " + q<IB,FB>();
+
+        /*
+         * Exact operand values as num / 2^(FA+FB).
+         */
+        auto num_a = [](long long ra) { return int_128{ ra } << FB; };
+        auto num_b = [](long long rb) { return int_128{ rb } << FA; };
+        const int_128 den = int_128{ 1 } << (FA+FB);
+
+        h.run("add " + fab, BITS_A, BITS_B, [&](long long ra, long long rb)
+        {
+            long long ref = quantize(num_a(ra) + num_b(rb), den, IA, FA);
+            A a = from_raw<IA,FA>(ra);
+            B b = from_raw<IB,FB>(rb);
+            A c = a;
+            c += b;
+            return (a + b).get_raw() == ref && c.get_raw() == ref;
+        });
+        h.run("sub " + fab, BITS_A, BITS_B, [&](long long ra, long long rb)
+        {
+            long long ref = quantize(num_a(ra) - num_b(rb), den, IA, FA);
+            A a = from_raw<IA,FA>(ra);
+            B b = from_raw<IB,FB>(rb);
+            A c = a;
+            c -= b;
+            return (a - b).get_raw() == ref && c.get_raw() == ref;
+        });
+        h.run("mul " + fab, BITS_A, BITS_B, [&](long long ra, long long rb)
+        {
+            long long ref = quantize(
+                    int_128{ ra } * rb, den, IP, FP);
+            long long ref_assign = quantize(
+                    ref, int_128{ 1 } << FP, IA, FA);
+            A a = from_raw<IA,FA>(ra);
+            B b = from_raw<IB,FB>(rb);
+            A c = a;
+            c *= b;
+            return (a * b).get_raw() == ref && c.get_raw() == ref_assign;
+        });
+        h.run("div " + fab, BITS_A, BITS_B, [&](long long ra, long long rb)
+        {
+            if (rb == 0)
+                return true;
+            int_128 num = num_a(ra);
+            int_128 div = num_b(rb);
+            if (div < 0)
+            {
+                num = -num;
+                div = -div;
+            }
+            long long ref = quantize(num, div, IA, FA);
+            A a = from_raw<IA,FA>(ra);
+            B b = from_raw<IB,FB>(rb);
+            A c = a;
+            c /= b;
+            return (a / b).get_raw() == ref && c.get_raw() == ref;
+        });
+        h.run("exact " + fab, BITS_A, BITS_B, [&](long long ra, long long rb)
+        {
+            // Narrowing an exact result rounds like the FixedPoint operators.
+            A a = from_raw<IA,FA>(ra);
+            B b = from_raw<IB,FB>(rb);
+            auto ea = make_exact_fixed_point(a);
+            auto eb = make_exact_fixed_point(b);
+            constexpr int IM = std::min(IA+IB, 32), FM = std::min(FA+FB, 32);
+            return (ea * eb).get_raw() == ra * rb &&
+                   (ea * eb).template round_to<IM,FM>() == a * b &&
+                   (ea + eb).template round_to<IA,FA>() == a + b &&
+                   (ea - eb).template round_to<IA,FA>() == a - b &&
+                   (-ea).template round_to<IA,FA>() == -a;
+        });
+        h.run("int " + fab, BITS_A, BITS_B, [&](long long ra, long long rb)
+        {
+            // The raw right hand side operand is used as an integer.
+            constexpr int IN = std::min(IA+32, 32);
+            const int_128 den_a = int_128{ 1 } << FA;
+            const int n = static_cast<int>(rb);
+            A a = from_raw<IA,FA>(ra);
+            A c = a;
+            bool ok = (a * n).get_raw() ==
+                          quantize(int_128{ ra } * rb, den_a, IN, FA) &&
+                      (c *= n).get_raw() ==
+                          quantize(int_128{ ra } * rb, den_a, IA, FA) &&
+                      (a + n).get_raw() ==
+                          quantize(ra + int_128{ rb } * den_a, den_a, IA, FA) &&
+                      (a - n).get_raw() ==
+                          quantize(ra - int_128{ rb } * den_a, den_a, IA, FA);
+            if (rb != 0)
+            {
+                int_128 num = rb < 0 ? -int_128{ ra } : int_128{ ra };
+                int_128 div = (rb < 0 ? -int_128{ rb } : int_128{ rb }) << FA;
+                ok = ok && (a / n).get_raw() == quantize(num, div, IA, FA);
+            }
+            return ok;
+        });
+        h.run("shift " + fa, BITS_A, 4, [&](long long ra, long long rb)
+        {
+            const int n = static_cast<int>(rb) + 8;
+            const int_128 den_a = int_128{ 1 } << FA;
+            A a = from_raw<IA,FA>(ra);
+            bool ok = (a >> n).get_raw() ==
+                          quantize(ra, den_a << n, IA, FA) &&
+                      (a << n).get_raw() ==
+                          quantize(int_128{ ra } << n, den_a, IA, FA);
+            if (n == 3)
+            {
+                ok = ok && a.template mul_pow2<3>() == (a << 3) &&
+                           a.template mul_pow2<-3>() == (a >> 3);
+            }
+            return ok;
+        });
+        h.run("mul_const " + fab, BITS_A, 0, [&](long long ra, long long)
+        {
+            // Shift-add multiplication by the extreme and a few other raw
+            // constants of the right hand side format.
+            using fixed_point_detail::const_multiplier;
+            constexpr long long MIN = -(1ll << (BITS_B-1));
+            constexpr long long MAX = (1ll << (BITS_B-1)) - 1;
+            constexpr long long MIXED = 0x5B3 & MAX;
+            A a = from_raw<IA,FA>(ra);
+            return const_multiplier::shift_add<IB,FB,MIN>(a) ==
+                       a * from_raw<IB,FB>(MIN) &&
+                   const_multiplier::shift_add<IB,FB,MAX>(a) ==
+                       a * from_raw<IB,FB>(MAX) &&
+                   const_multiplier::shift_add<IB,FB,-MIXED>(a) ==
+                       a * from_raw<IB,FB>(-MIXED) &&
+                   mul_const<IB,FB,-1>(a) == a * from_raw<IB,FB>(-1) &&
+                   mul_const<IB,FB,MIXED>(a) == a * from_raw<IB,FB>(MIXED);
+        });
+        h.run("compare " + fab, BITS_A, BITS_B,
+              [&](long long ra, long long rb)
+        {
+            int_128 x = num_a(ra), y = num_b(rb);
+            A a = from_raw<IA,FA>(ra);
+            B b = from_raw<IB,FB>(rb);
+            return (a == b) == (x == y) && (a != b) == (x != y) &&
+                   (a <  b) == (x <  y) && (a <= b) == (x <= y) &&
+                   (a >  b) == (x >  y) && (a >= b) == (x >= y);
+        });
+
+        /*
+         * Unary operations and conversions of the left hand side format.
+         */
+        h.run("neg " + fa, BITS_A, 0, [&](long long ra, long long)
+        {
+            long long ref = quantize(-int_128{ ra }, int_128{ 1 } << FA,
+                                     IA, FA);
+            return (-from_raw<IA,FA>(ra)).get_raw() == ref;
+        });
+        h.run("convert " + fa + " to " + q<IB,FB>(), BITS_A, 0,
+              [&](long long ra, long long)
+        {
+            long long ref = quantize(ra, int_128{ 1 } << FA, IB, FB);
+            A a = from_raw<IA,FA>(ra);
+            B b{ a };
+            B c{};
+            c = a;
+            return b.get_raw() == ref && c.get_raw() == ref;
+        });
+        h.run("double " + fa, BITS_A, 0, [&](long long ra, long long)
+        {
+            double d = std::ldexp(static_cast<double>(ra), -FA);
+            A a = from_raw<IA,FA>(ra);
+            return static_cast<double>(a) == d && A{ d }.get_raw() == ra;
+        });
+    }
+}
+
+int main(int argc, char **argv)
+{
+    Harness h{ argc > 1 ? argv[1] : "" };
+
+    // Same formats, small and with many fractional bits.
+    verify_pair<4,4, 4,4>(h);
+    verify_pair<6,6, 6,6>(h);
+    verify_pair<1,11, 1,11>(h);
+
+    // Mixed formats, widening and narrowing conversions.
+    verify_pair<8,4, 4,8>(h);
+    verify_pair<3,9, 10,2>(h);
+    verify_pair<12,0, 2,10>(h);
+
+    // Negative number of integer bits.
+    verify_pair<-2,12, 0,12>(h);
+
+    // Products with 32 fractional bits, exact and rounded towards -INF.
+    verify_pair<-6,12, -8,20>(h);
+    verify_pair<-10,22, -10,22>(h);
+
+    // Sums and quotients with 32 fractional bits.
+    verify_pair<-20,32, 2,10>(h);
+
+    return h.finish();
+}
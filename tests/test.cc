@@ -99,6 +99,135 @@ TEST_CASE("Floating-point constructor")
 
 }
 
+TEST_CASE("FixedPoint literals")
+{
+    /*
+     * Literals round like the floating-point constructor.
+     */
+    REQUIRE(FixedPoint<4,28>{ 1.5_fxp } == FixedPoint<4,28>{ 1.5 });
+    REQUIRE(FixedPoint<1,15>{ 0.3_fxp } == FixedPoint<1,15>{ 0.3 });
+    REQUIRE(FixedPoint<1,15>{ -0.3_fxp } == FixedPoint<1,15>{ -0.3 });
+    REQUIRE(FixedPoint<8,8>{ 2.5e-2_fxp } == FixedPoint<8,8>{ 0.025 });
+    REQUIRE(FixedPoint<20,4>{ 12'345.678_fxp } ==
+            FixedPoint<20,4>{ 12345.678 });
+    REQUIRE(FixedPoint<3,0>{ 2_fxp } == FixedPoint<3,0>{ 2 });
+    REQUIRE(FixedPoint<4,32>{ 3.14159265358979323846_fxp } ==
+            FixedPoint<4,32>{ 3.14159265358979323846 });
+
+    /*
+     * Ties round upwards.
+     */
+    REQUIRE(FixedPoint<8,1>{ 0.25_fxp }.get_raw() == 1);
+    REQUIRE(FixedPoint<8,1>{ -0.25_fxp }.get_raw() == 0);
+    REQUIRE(FixedPoint<8,1>{ -0.75_fxp }.get_raw() == -1);
+
+    /*
+     * Extreme values of the format.
+     */
+    FixedPoint<1,15> min = -1.0_fxp;
+    FixedPoint<1,15> max = 0.999969482421875_fxp;
+    REQUIRE(min.get_raw() == -32768);
+    REQUIRE(max.get_raw() == 32767);
+    REQUIRE(FixedPoint<1,15>{ 1e-300_fxp }.get_raw() == 0);
+}
+
+TEST_CASE("Arithmetic with integers and powers of two.")
+{
+    /*
+     * Integer operands behave like FixedPoint<32,0> operands.
+     */
+    const int ints[] = { 0, 1, -1, 2, 3, -3, 7, -10, 100, 4096, -65537 };
+    FixedPoint<4,8> x{};
+    for (long long raw=-2048; raw<2048; ++raw)
+    {
+        x.set_raw(raw);
+        for (int n : ints)
+        {
+            FixedPoint<32,0> fix_n{ n };
+            REQUIRE(x * n == x * fix_n);
+            REQUIRE((x * n).get_int_bits() == 32);
+            REQUIRE(n * x == x * fix_n);
+            REQUIRE(x + n == x + fix_n);
+            REQUIRE(x - n == x - fix_n);
+            if (n != 0)
+                REQUIRE(x / n == x / fix_n);
+
+            FixedPoint<4,8> y{ x };
+            REQUIRE((y *= n) == (FixedPoint<4,8>{ x } *= fix_n));
+        }
+
+        /*
+         * Right shifts round to nearest, ties upwards.
+         */
+        for (int n=0; n<12; ++n)
+        {
+            long long half{ n ? 1ll << (n-1) : 0 };
+            REQUIRE((x >> n).get_raw() == (raw + half) >> n);
+            FixedPoint<4,8> wrapped{};
+            wrapped.set_raw(raw << n);
+            REQUIRE((x << n) == wrapped);
+        }
+        REQUIRE(x.mul_pow2<3>() == (x << 3));
+        REQUIRE(x.mul_pow2<-5>() == (x >> 5));
+        REQUIRE(x.mul_pow2<0>() == x);
+    }
+
+    /*
+     * Negative integers, 32 fractional bits and other integer types.
+     */
+    FixedPoint<32,32> big{ -2147483648.0 };
+    REQUIRE(big / -1 == big / FixedPoint<32,0>{ -1 });
+    REQUIRE(big * 3ll == big * FixedPoint<32,0>{ 3 });
+    FixedPoint<3,32> small{ -0.1 };
+    REQUIRE(small / 7u == small / FixedPoint<32,0>{ 7 });
+    REQUIRE((small >> 3).get_raw() == small.get_raw() >> 3);
+    FixedPoint<-2,12> tiny{ -0.05 };
+    REQUIRE((tiny * 5).get_int_bits() == 30);
+    REQUIRE(static_cast<double>(tiny * 5) == 5*static_cast<double>(tiny));
+}
+
+TEST_CASE("Multiplication by constants.")
+{
+    using fixed_point_detail::const_multiplier;
+    REQUIRE(fixed_point_csd_digits(0) == 0);
+    REQUIRE(fixed_point_csd_digits(-1) == 1);
+    REQUIRE(fixed_point_csd_digits(7) == 2);
+    REQUIRE(fixed_point_csd_digits(0b1011011) == 4);
+    REQUIRE(fixed_point_csd_digits(-32768) == 1);
+    REQUIRE(fixed_point_csd_digits(9830) == 7);
+
+    /*
+     * Shift-add multiplication rounds like operator*, whatever the number of
+     * CSD digits and the multiplication scenario.
+     */
+    FixedPoint<1,15> x{};
+    for (long long raw=-32768; raw<32768; raw+=7)
+    {
+        x.set_raw(raw);
+        FixedPoint<1,15> c{};
+        c.set_raw(9830);
+        REQUIRE(mul_const<1,15,9830>(x) == x * c);
+        REQUIRE((const_multiplier::shift_add<1,15,9830>(x) == x * c));
+        REQUIRE(mul_const<1,15>(x, 0.3_fxp) == x * c);
+        c.set_raw(-32768);
+        REQUIRE(mul_const<1,15,-32768>(x) == x * c);
+        FixedPoint<3,2> k{};
+        k.set_raw(-7);
+        REQUIRE(mul_const<3,2,-7>(x) == x * k);
+        REQUIRE(mul_const<3,2,-7>(x).get_frac_bits() == 17);
+
+        // Products with more than 32 fractional bits, in 64 and 128 bits.
+        FixedPoint<4,28> y{ x };
+        FixedPoint<2,30> d{};
+        d.set_raw(0x2AAAAAAB);
+        REQUIRE((const_multiplier::shift_add<2,30,0x2AAAAAAB>(y) == y * d));
+        FixedPoint<20,30> w{ y * 12345 };
+        REQUIRE((const_multiplier::shift_add<2,30,0x2AAAAAAB>(w) == w * d));
+        REQUIRE(mul_const<2,30,-0x1000000>(w) ==
+                w * FixedPoint<2,30>{ -1/64.0 });
+    }
+}
+
 TEST_CASE("Fixed point to floating point conversion introductory test.")
 {
     FixedPoint<6,10> fix_a{ -5.25 };
@@ -248,6 +377,30 @@ TEST_CASE("Multiplication of Fixed Point Numbers")
         REQUIRE(result.str() == std::string("-73 + 2415919104/4294967296"));
     }
 
+    /*
+     * Multiplication when INT_BITS+FRAC_BITS > 32 for one operand, but the
+     * operands have no more than 64 significant bits in total.
+     */
+    {
+        std::stringstream result{};
+        FixedPoint<3,30> fix_a{};
+        FixedPoint<1,30> fix_b{};
+        fix_a.set_raw(-(1ll << 32));
+        fix_b.set_raw(-(1ll << 30));
+        result << fix_a * fix_b;
+        REQUIRE(result.str() == std::string("4 + 0/4294967296"));
+    }
+    {
+        std::stringstream result{};
+        FixedPoint<3,30> fix_a{};
+        FixedPoint<1,30> fix_b{};
+        fix_a.set_raw((1ll << 32) - 1);
+        fix_b.set_raw((1ll << 30) - 1);
+        result << fix_a * fix_b << " " << -fix_a * fix_b;
+        REQUIRE(result.str() == std::string(
+                "3 + 4294967276/4294967296 -4 + 19/4294967296"));
+    }
+
     /*
      * Some more tests.
      */
@@ -298,6 +451,32 @@ TEST_CASE("Fixed point division")
         result << fix_a/fix_b;
         REQUIRE(result.str() == std::string("2 + 1973790/8388608"));
     }
+
+    /*
+     * Inexact negative quotients are rounded from their value, and not from
+     * their Q(32,32) quotient truncated towards zero. Here, the quotient is
+     * -2^-9 - 2^-9/16777217, just below the tie between -2^-8 and zero, but
+     * truncated to 32 fractional bits it is exactly the tie, which rounds up.
+     * The positive quotient is just above the tie either way.
+     */
+    {
+        FixedPoint<17,8> fix_a{};
+        fix_a.set_raw(-8388609);
+        FixedPoint<32,0> fix_b{ 16777217 };
+        REQUIRE((fix_a/fix_b).get_raw() == -1);
+        REQUIRE((-fix_a/fix_b).get_raw() == 1);
+    }
+
+    /*
+     * Numbers with 32 fractional bits round towards -INF, also when the
+     * quotient is negative.
+     */
+    {
+        FixedPoint<2,32> fix_a{ -1.0 };
+        FixedPoint<4,0> fix_b{ 3.0 };
+        REQUIRE((fix_a/fix_b).get_raw() == -1431655766);
+        REQUIRE((-fix_a/fix_b).get_raw() == 1431655765);
+    }
 }
 
 TEST_CASE("Approximate pi using Leibniz formula")
@@ -309,21 +488,21 @@ TEST_CASE("Approximate pi using Leibniz formula")
     const double pi = 3.1415926535;
     const int ITERATIONS=10000000;
 
-    FixedPoint<4,32> pi_fixed{ 4.0 };
-    FixedPoint<32,0> divisor{ 3.0 };
+    FixedPoint<4,32> pi_fixed{ 4.0_fxp };
+    FixedPoint<32,0> divisor{ 3.0_fxp };
     for (int i=0; i<ITERATIONS; ++i)
     {
         if (i % 2)
         {
             // Odd iteration.
-            pi_fixed += FixedPoint<4,32>{4.0}/divisor;
+            pi_fixed += FixedPoint<4,32>{4.0_fxp}/divisor;
         }
         else
         {
             // Even iteration.
-            pi_fixed -= FixedPoint<4,32>{4.0}/divisor;
+            pi_fixed -= FixedPoint<4,32>{4.0_fxp}/divisor;
         }
-        divisor += FixedPoint<3,0>{2};
+        divisor += FixedPoint<3,0>{2_fxp};
     }
 
     std::cout << std::endl;
@@ -404,9 +583,10 @@ TEST_CASE("Conversion from BIG fixed point numbers to floating point conversion.
 TEST_CASE("Multiplication performance.")
 {
     /*
-     * Multiplication with 'short' will result in multiplication scenario 1
-     * (described in FixedPoint.h) and multiplication with 'long' will result
-     * in multiplication scenario 2.
+     * Multiplication with 'short' and multiplication with 'long' will both
+     * result in multiplication scenario 1 (described in FixedPoint.h), as the
+     * operands of the latter still have no more than 64 significant bits in
+     * total.
      */
     using namespace std::chrono;
     const int ITERATIONS=10000000;
@@ -450,7 +630,7 @@ TEST_CASE("Multiplication performance.")
     }
 
     /*
-     * Long multiplication, scenario 2.
+     * Long multiplication, scenario 1.
      */
     {
         FixedPoint<3,30> fix_long{ 0.9999995 };
@@ -535,3 +715,51 @@ TEST_CASE("Overflow tests")
     }
 }
 
+
+TEST_CASE("Raw integer get/set.")
+{
+    FixedPoint<10,4> fix{};
+    fix.set_raw(-306);
+    REQUIRE(static_cast<double>(fix) == -19.125);
+    REQUIRE(fix.get_raw() == -306);
+
+    // Bits outside of the format are truncated.
+    fix.set_raw((1ll << 14) + 52);
+    REQUIRE(fix.get_raw() == 52);
+    fix.set_raw((1ll << 13) + 52);
+    REQUIRE(fix.get_raw() == 52 - (1ll << 13));
+}
+
+TEST_CASE("FixedPointSpan over integer buffers.")
+{
+    /*
+     * Q(1,15) samples in a 16-bit buffer.
+     */
+    {
+        std::int16_t buffer[] = { 16384, -32768, 0, 32767 };
+        FixedPointSpan<1,15,std::int16_t> span{ buffer, 4 };
+        REQUIRE(span.size() == 4);
+        REQUIRE(static_cast<double>(span.get(0)) == 0.5);
+        REQUIRE(static_cast<double>(span.get(1)) == -1.0);
+
+        // Write through the view, with rounding to the element format.
+        span[2] = FixedPoint<1,15>{ span[0] } * FixedPoint<1,15>{ span[1] };
+        REQUIRE(buffer[2] == -16384);
+        span[3] = FixedPoint<4,20>{ 0.25 + 1.0/(1 << 17) };
+        REQUIRE(buffer[3] == 8192);
+        span[0] = span[1];
+        REQUIRE(buffer[0] == -32768);
+    }
+
+    /*
+     * Read-only Q(8,24) view over 32-bit data, and subspans.
+     */
+    {
+        const std::int32_t buffer[] = { 1 << 24, -(3 << 23), 5 << 22 };
+        auto span = make_fixed_point_span<8,24>(buffer, 3);
+        auto tail = span.subspan(1, 2);
+        REQUIRE(tail.size() == 2);
+        REQUIRE(static_cast<double>(tail.get(0)) == -1.5);
+        REQUIRE(static_cast<double>(FixedPoint<8,24>{ tail[1] }) == 1.25);
+    }
+}
@@ -0,0 +1,116 @@
+#include "catch.hpp"
+#include "FixedPointAtomic.h"
+#include <climits>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("Atomic operations round and wrap like the FixedPoint operators.")
+{
+    AtomicFixedPoint<4,8> atomic{};
+    REQUIRE(atomic.is_lock_free());
+    FixedPoint<4,8> reference{};
+
+    /*
+     * Addends with more fractional bits, including ties, and overflows.
+     */
+    FixedPoint<6,12> rhs{};
+    for (long long raw=-(1ll << 17); raw<(1ll << 17); raw+=5)
+    {
+        rhs.set_raw(raw);
+        REQUIRE(atomic.fetch_add(rhs) == reference);
+        reference += rhs;
+        REQUIRE(atomic.load() == reference);
+        REQUIRE(atomic.fetch_sub(rhs) == reference);
+        reference -= rhs;
+        REQUIRE(atomic.load() == reference);
+        atomic.fetch_add(rhs, std::memory_order_relaxed);
+        reference += rhs;
+    }
+
+    /*
+     * Numbers with 32 fractional bits, which round towards -INF.
+     */
+    AtomicFixedPoint<2,32> frac32{ FixedPoint<2,32>{ 1.75 } };
+    FixedPoint<2,32> reference32{ 1.75 };
+    FixedPoint<32,32> tiny{};
+    tiny.set_raw(3);
+    frac32.fetch_sub(tiny);
+    reference32 -= tiny;
+    REQUIRE(frac32.load() == reference32);
+    frac32.fetch_add(FixedPoint<8,4>{ 3.5 });
+    reference32 += FixedPoint<8,4>{ 3.5 };
+    REQUIRE(frac32.load() == reference32);
+
+    /*
+     * Subtraction of the most negative Q(32,32) number, -2^31, whose
+     * negation wraps around.
+     */
+    FixedPoint<32,32> most_negative{};
+    most_negative.set_raw(LLONG_MIN);
+    AtomicFixedPoint<32,32> wide{ FixedPoint<32,32>{ 1.0 } };
+    wide.fetch_sub(most_negative);
+    FixedPoint<32,32> expected_wide{};
+    expected_wide.set_raw(LLONG_MIN + (1ll << 32));
+    REQUIRE(wide.load() == expected_wide);
+    FixedPoint<4,8> before{ atomic.load() };
+    atomic.fetch_sub(most_negative);
+    REQUIRE(atomic.load() == before);
+
+    /*
+     * Exchange and compare-and-swap.
+     */
+    FixedPoint<4,8> expected{ 1.0 };
+    REQUIRE(atomic.exchange(expected) == reference);
+    REQUIRE(atomic.compare_exchange_strong(expected, FixedPoint<4,8>{ 2.5 }));
+    REQUIRE_FALSE(atomic.compare_exchange_strong(
+            expected, FixedPoint<4,8>{ -3.0 }));
+    REQUIRE(expected == FixedPoint<4,8>{ 2.5 });
+    while (!atomic.compare_exchange_weak(expected, FixedPoint<4,8>{ -7.25 }))
+        ;
+    REQUIRE(atomic.load() == FixedPoint<4,8>{ -7.25 });
+    atomic.store(FixedPoint<4,8>{ 7.5 });
+    REQUIRE(atomic.load() == FixedPoint<4,8>{ 7.5 });
+}
+
+TEST_CASE("Concurrent accumulation equals sequential accumulation.")
+{
+    const int threads = 8;
+    const int adds = 20000;
+    auto value = [](int t, int i)
+    {
+        FixedPoint<3,20> x{};
+        x.set_raw((t * 7919ll + i * 104729ll) % (1ll << 22) - (1ll << 21));
+        return x;
+    };
+
+    FixedPoint<6,12> reference{};
+    for (int t=0; t<threads; ++t)
+        for (int i=0; i<adds; ++i)
+            reference += value(t, i);
+
+    AtomicFixedPoint<6,12> atomic{};
+    ShardedFixedPointAccumulator<6,12,4> sharded{};
+    std::vector<std::thread> pool{};
+    for (int t=0; t<threads; ++t)
+    {
+        pool.emplace_back([&, t]
+        {
+            for (int i=0; i<adds; ++i)
+            {
+                atomic.fetch_add(value(t, i), std::memory_order_relaxed);
+                sharded.add(value(t, i));
+            }
+        });
+    }
+    for (std::thread &t : pool)
+        t.join();
+    REQUIRE(atomic.load() == reference);
+    REQUIRE(sharded.load() == reference);
+
+    sharded.sub(reference);
+    REQUIRE(sharded.load() == FixedPoint<6,12>{});
+    sharded.add(FixedPoint<6,12>{ 1.5 });
+    sharded.reset();
+    REQUIRE(sharded.load() == FixedPoint<6,12>{});
+}
@@ -0,0 +1,97 @@
+#include "catch.hpp"
+#include "FixedPointExact.h"
+#include <type_traits>
+#include <cstdint>
+
+
+TEST_CASE("Exact result formats grow instead of rounding.")
+{
+    FixedPoint<4,12> a{ 1.3 };
+    FixedPoint<2,14> b{ -0.7 };
+    auto ea = make_exact_fixed_point(a);
+    auto eb = make_exact_fixed_point(b);
+
+    auto sum = ea + eb;
+    REQUIRE(sum.get_int_bits() == 5);
+    REQUIRE(sum.get_frac_bits() == 14);
+    REQUIRE(static_cast<double>(sum) ==
+            static_cast<double>(a) + static_cast<double>(b));
+
+    auto prod = ea * eb;
+    REQUIRE(prod.get_int_bits() == 6);
+    REQUIRE(prod.get_frac_bits() == 26);
+    REQUIRE(static_cast<double>(prod) ==
+            static_cast<double>(a) * static_cast<double>(b));
+    REQUIRE((-prod).get_int_bits() == 7);
+    REQUIRE(static_cast<double>(-prod) == -static_cast<double>(prod));
+
+    /*
+     * Results are stored in the narrowest sufficient integer, and are not
+     * limited to Q(32,32).
+     */
+    static_assert(std::is_same<decltype(sum)::storage_type,
+                               std::int32_t>::value, "");
+    static_assert(std::is_same<decltype(prod)::storage_type,
+                               std::int32_t>::value, "");
+    auto wide = prod * prod * prod;
+    REQUIRE(wide.get_int_bits() == 18);
+    REQUIRE(wide.get_frac_bits() == 78);
+    static_assert(sizeof(decltype(wide)::storage_type) == 16, "");
+    REQUIRE(static_cast<double>(wide) ==
+            Approx(std::pow(static_cast<double>(prod), 3)));
+
+    /*
+     * Narrowing rounds once, like a FixedPoint conversion of the exact result.
+     */
+    REQUIRE((prod.round_to<6,26>() == a * b));
+    REQUIRE((prod.round_to<2,14>() == FixedPoint<2,14>{ a * b }));
+    REQUIRE((sum.round_to<3,2>() == FixedPoint<3,2>{ 0.5 }));
+
+    // Numbers with 32 fractional bits round towards -INF.
+    FixedPoint<1,30> lsb{};
+    lsb.set_raw(1);
+    auto cube = make_exact_fixed_point(lsb) * make_exact_fixed_point(lsb) *
+                make_exact_fixed_point(lsb);
+    REQUIRE(cube.get_frac_bits() == 90);
+    REQUIRE(cube.round_to<4,32>().get_raw() == 0);
+    REQUIRE((-cube).round_to<4,32>().get_raw() == -1);
+    REQUIRE((-cube).round_to<4,31>().get_raw() == 0);
+
+    /*
+     * Comparisons of different formats.
+     */
+    REQUIRE(eb < ea);
+    REQUIRE(sum == ea + eb);
+    REQUIRE(sum != ea);
+    REQUIRE(prod <= prod);
+    REQUIRE(ea >= eb);
+}
+
+TEST_CASE("Exact accumulation wraps around but never rounds.")
+{
+    /*
+     * Dot product of Q(1,15) vectors into a Q(8,30) accumulator.
+     */
+    ExactFixedPoint<8,30> acc{};
+    FixedPoint<12,30> reference{};
+    for (int i=0; i<200; ++i)
+    {
+        FixedPoint<1,15> x{ 0.01 * (i % 97) - 0.3 };
+        FixedPoint<1,15> h{ 0.0071 * (i % 13) };
+        acc += make_exact_fixed_point(x) * make_exact_fixed_point(h);
+        reference += x * h;
+    }
+    REQUIRE((acc.round_to<12,30>() == reference));
+    REQUIRE((acc.round_to<1,15>() == FixedPoint<1,15>{ reference }));
+
+    /*
+     * Overflow wraps around to the accumulator format.
+     */
+    ExactFixedPoint<2,4> small{ FixedPoint<2,4>{ 1.5 } };
+    small += ExactFixedPoint<1,2>{ FixedPoint<1,2>{ 0.75 } };
+    REQUIRE(static_cast<double>(small) == -1.75);
+    small -= ExactFixedPoint<2,0>{ FixedPoint<2,0>{ 1 } };
+    REQUIRE(static_cast<double>(small) == 1.25);
+
+    REQUIRE(ExactFixedPoint<2,4>::from_raw(37).get_raw() == -27);
+}
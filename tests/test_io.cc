@@ -0,0 +1,359 @@
+#include "catch.hpp"
+#include "FixedPointIO.h"
+#include <algorithm>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+
+
+/*
+ * File in the temporary directory, removed when the test case ends, also
+ * when it fails.
+ */
+struct TemporaryFile
+{
+    const std::string path;
+
+    explicit TemporaryFile(const std::string &name)
+        : path{ directory() + "/poor_mans_fixed_point_" + name }
+    {
+    }
+    TemporaryFile(const TemporaryFile &) = delete;
+    TemporaryFile &operator=(const TemporaryFile &) = delete;
+    ~TemporaryFile() { std::remove(this->path.c_str()); }
+
+private:
+    static std::string directory()
+    {
+        const char *tmpdir{ std::getenv("TMPDIR") };
+        return tmpdir && *tmpdir ? tmpdir : "/tmp";
+    }
+};
+
+TEST_CASE("Raw integer access.")
+{
+    FixedPoint<10,4> fix_a{ 3.25 }, fix_b{ -19.125 };
+    REQUIRE(fix_a.get_raw() == 52);
+    REQUIRE(fix_b.get_raw() == -306);
+}
+
+TEST_CASE("Text writer formats.")
+{
+    FixedPoint<10,4> fix[] = {
+        FixedPoint<10,4>{ 3.25 }, FixedPoint<10,4>{ -19.125 },
+        FixedPoint<10,4>{ 0.0 },  FixedPoint<10,4>{ -0.0625 }
+    };
+
+    /*
+     * Exact decimal form.
+     */
+    {
+        std::stringstream result{};
+        FixedPointTextWriter writer{ result, FixedPointTextFormat::decimal };
+        writer.write(fix, 4);
+        writer.flush();
+        REQUIRE(result.str() == std::string("3.25\n-19.125\n0\n-0.0625\n"));
+    }
+
+    /*
+     * Raw hexadecimal form, four columns.
+     */
+    {
+        std::stringstream result{};
+        FixedPointTextWriter writer{ result, FixedPointTextFormat::raw_hex, 4 };
+        writer.write(fix, 4);
+        writer.flush();
+        REQUIRE(result.str() == std::string("0x0034,0x3ece,0x0000,0x3fff\n"));
+    }
+
+    /*
+     * Quotient form should equal that of operator<<.
+     */
+    {
+        std::stringstream result{}, reference{};
+        FixedPointTextWriter writer{ result, FixedPointTextFormat::quotient };
+        for (const auto &f : fix)
+        {
+            writer.write(f);
+            reference << f << "\n";
+        }
+        writer.flush();
+        REQUIRE(result.str() == reference.str());
+    }
+
+    /*
+     * Extreme values of a Q(32,32) number.
+     */
+    {
+        std::stringstream result{};
+        FixedPoint<32,32> min{ -2147483647-1, 0u }, max{ 2147483647, ~0u };
+        FixedPointTextWriter writer{ result, FixedPointTextFormat::decimal, 2 };
+        writer.write(min);
+        writer.write(max);
+        writer.flush();
+        REQUIRE(result.str() == std::string(
+            "-2147483648,2147483647.99999999976716935634613037109375\n"));
+    }
+}
+
+TEST_CASE("Parallel text writer output equals sequential output.")
+{
+    std::vector<FixedPoint<8,12>> data{};
+    for (int i=0; i<10007; ++i)
+        data.emplace_back( (i - 5000) / 37.0 );
+
+    std::stringstream sequential{}, parallel{};
+    {
+        FixedPointTextWriter writer{
+            sequential, FixedPointTextFormat::decimal, 3 };
+        writer.write(data.data(), data.size());
+    }
+    {
+        // Several calls, each formatted in parallel by the same threads.
+        FixedPointTextWriter writer{
+            parallel, FixedPointTextFormat::decimal, 3, ';', 4, 100 };
+        for (std::size_t begin=0; begin<data.size(); begin+=2501)
+        {
+            std::size_t n = std::min<std::size_t>(2501, data.size() - begin);
+            writer.write(data.data() + begin, n);
+        }
+    }
+    std::string seq{ sequential.str() }, par{ parallel.str() };
+    std::replace(par.begin(), par.end(), ';', ',');
+    REQUIRE(seq == par);
+}
+
+TEST_CASE("Text writer stream errors.")
+{
+    /*
+     * Stream buffer that fails every write.
+     */
+    struct FailingBuffer : std::streambuf
+    {
+        int_type overflow(int_type) override { return traits_type::eof(); }
+    };
+    FailingBuffer buffer{};
+    std::ostream os{ &buffer };
+    os.exceptions(std::ios::badbit);
+
+    // flush() reports the error, the destructor ignores it.
+    FixedPointTextWriter writer{ os };
+    writer.write(FixedPoint<4,4>{ 1.5 });
+    REQUIRE_THROWS_AS(writer.flush(), std::ios::failure);
+}
+
+TEST_CASE("Bit-packed binary serialization round trip.")
+{
+    /*
+     * Twelve bit numbers, two of them pack into three bytes.
+     */
+    {
+        FixedPoint<3,9> data[] = {
+            FixedPoint<3,9>{ -4.0 }, FixedPoint<3,9>{ 3.998046875 },
+            FixedPoint<3,9>{ -0.001953125 }
+        };
+        unsigned char packed[packed_size<3,9>(3)]{};
+        REQUIRE(sizeof(packed) == 5);
+        pack_bits(data, 3, packed);
+        REQUIRE(packed[0] == 0x00);
+        REQUIRE(packed[1] == 0xF8);
+        REQUIRE(packed[2] == 0x7F);
+        REQUIRE(packed[3] == 0xFF);
+        REQUIRE(packed[4] == 0x0F);
+
+        FixedPoint<3,9> unpacked[3]{};
+        unpack_bits(packed, 3, unpacked);
+        REQUIRE( (unpacked[0] == data[0] && unpacked[1] == data[1] &&
+                  unpacked[2] == data[2]) );
+    }
+
+    /*
+     * Streams of odd widths, up to the full 64 bits, with a length that is
+     * not a multiple of the chunk size.
+     */
+    {
+        std::vector<FixedPoint<5,12>> short_data{};
+        std::vector<FixedPoint<32,32>> long_data{};
+        for (int i=0; i<40000; ++i)
+        {
+            short_data.emplace_back( (i % 2000 - 1000) / 63.0 );
+            long_data.emplace_back( (i - 20000) * 104729.123456 );
+        }
+
+        std::stringstream stream{};
+        write_binary(stream, short_data.data(), short_data.size());
+        REQUIRE(stream.str().size() == 16 + (40000*17+7)/8);
+        REQUIRE(read_binary<5,12>(stream) == short_data);
+
+        stream.str("");
+        write_binary(stream, long_data.data(), long_data.size());
+        REQUIRE(read_binary<32,32>(stream) == long_data);
+    }
+
+    /*
+     * Q-format mismatch should throw.
+     */
+    {
+        std::stringstream stream{};
+        FixedPoint<5,12> fix{ 1.5 };
+        write_binary(stream, &fix, 1);
+        REQUIRE_THROWS_AS((read_binary<5,11>(stream)), std::runtime_error);
+    }
+}
+
+TEST_CASE("Memory mapped sample files.")
+{
+    const TemporaryFile temporary{ "sample_file_test.bin" };
+    const std::string &path{ temporary.path };
+    std::vector<FixedPoint<3,9>> short_data{};
+    std::vector<FixedPoint<20,30>> long_data{};
+    for (int i=0; i<10000; ++i)
+    {
+        short_data.emplace_back( (i % 4096 - 2048) / 512.0 );
+        long_data.emplace_back( (i - 5000) * 99.123456789 );
+    }
+
+    /*
+     * Twelve bit numbers are stored as 16-bit integers.
+     */
+    {
+        {
+            std::ofstream file{ path, std::ios::binary };
+            write_sample_file(file, short_data.data(), short_data.size());
+        }
+        FixedPointSampleFile<3,9> samples{ path };
+        REQUIRE(samples.size() == short_data.size());
+        REQUIRE(sizeof(*samples.raw_data()) == 2);
+        REQUIRE(samples.raw_data()[1] == short_data[1].get_raw());
+        REQUIRE(samples.span().get(2) == short_data[2]);
+        bool equal{ true };
+        for (std::size_t i=0; i<samples.size(); ++i)
+            equal = equal && (samples[i] == short_data[i]);
+        REQUIRE(equal);
+    }
+
+    /*
+     * Fifty bit numbers are stored as 64-bit integers.
+     */
+    {
+        {
+            std::ofstream file{ path, std::ios::binary };
+            write_sample_file(file, long_data.data(), long_data.size());
+        }
+        FixedPointSampleFile<20,30> samples{ path };
+        samples.advise_sequential();
+        REQUIRE(samples.size() == long_data.size());
+        bool equal{ true };
+        for (std::size_t i=0; i<samples.size(); ++i)
+            equal = equal && (samples[i] == long_data[i]);
+        REQUIRE(equal);
+    }
+
+    /*
+     * Opening with wrong format should throw.
+     */
+    REQUIRE_THROWS_AS((FixedPointSampleFile<20,29>{ path }),
+                      std::runtime_error);
+}
+
+TEST_CASE("NumPy .npy files.")
+{
+    const TemporaryFile temporary{ "npy_test.npy" };
+    const std::string &path{ temporary.path };
+    std::vector<FixedPoint<3,9>> data{};
+    for (int i=0; i<5000; ++i)
+        data.emplace_back( (i % 4096 - 2048) / 512.0 );
+
+    /*
+     * Round trip, with header aligned to 64 bytes.
+     */
+    {
+        {
+            std::ofstream file{ path, std::ios::binary };
+            write_npy(file, data.data(), data.size());
+        }
+        std::ifstream file{ path, std::ios::binary };
+        std::string content{ std::istreambuf_iterator<char>(file), {} };
+        REQUIRE(content.size() == 128 + 2*data.size());
+        REQUIRE(content.substr(10, 68) == std::string(
+            "{'descr': '<i2', 'fortran_order': False, 'shape': (5000,), } "
+            "# PoorM"));
+        REQUIRE(content[127] == '\n');
+        REQUIRE(read_npy<3,9>(path) == data);
+        REQUIRE_THROWS_AS((read_npy<4,8>(path)), std::runtime_error);
+    }
+
+    /*
+     * Writing from a span.
+     */
+    {
+        std::int16_t buffer[] = { 16384, -32768, 0, 32767 };
+        {
+            std::ofstream file{ path, std::ios::binary };
+            write_npy(file, make_fixed_point_span<1,15>(buffer, 4));
+        }
+        FixedPointNpyFile<1,15> file{ path };
+        REQUIRE(file.size() == 4);
+        REQUIRE(static_cast<double>(file[1]) == -1.0);
+        REQUIRE(file.span().data()[3] == 32767);
+    }
+
+    /*
+     * A file written by NumPy, without Q-format, of shape (2, 2) and 32-bit
+     * integers.
+     */
+    {
+        {
+            std::string dict{
+                "{'descr': '<i4', 'fortran_order': False, 'shape': (2, 2), }" };
+            dict.append((64 - (10 + dict.size() + 1) % 64) % 64, ' ');
+            dict.push_back('\n');
+            std::ofstream file{ path, std::ios::binary };
+            file.write("\x93NUMPY\x01\x00", 8);
+            file.put(static_cast<char>(dict.size())).put(0);
+            file << dict;
+            std::int32_t values[] = { 1 << 24, -(3 << 23), 5 << 22, -1 };
+            file.write(reinterpret_cast<const char *>(values), sizeof(values));
+        }
+        FixedPointNpyFile<8,24,std::int32_t> file{ path };
+        REQUIRE(file.size() == 4);
+        REQUIRE(static_cast<double>(file[1]) == -1.5);
+        REQUIRE(static_cast<double>(file[2]) == 1.25);
+        REQUIRE_THROWS_AS((FixedPointNpyFile<8,8>{ path }), std::runtime_error);
+    }
+
+    /*
+     * Malformed headers throw std::runtime_error, and nothing else.
+     */
+    const char *malformed[] = {
+        "{'descr': '<i2', 'fortran_order': False, 'shape': (4,), } "
+            "# PoorMansFixedPoint Q(",
+        "{'descr': '<i2', 'fortran_order': False, 'shape': (4,), } "
+            "# PoorMansFixedPoint Q(1,99999999999999999999)",
+        "{'descr': '<i2', 'fortran_order': False, "
+            "'shape': (99999999999999999999999,), }",
+        "{'descr': '<i2', 'fortran_order': False, "
+            "'shape': (4294967296, 4294967296), }",
+        "{'descr': '<i2', 'fortran_order': False, 'shape': (1000000000,), }",
+        "{'descr': '<i2', 'shape': (4,), 'fortran_order':      ",
+        "{'descr': '<i2 ",
+    };
+    for (const char *dict : malformed)
+    {
+        {
+            std::ofstream file{ path, std::ios::binary };
+            file.write("\x93NUMPY\x01\x00", 8);
+            file.put(static_cast<char>(std::strlen(dict))).put(0);
+            file << dict;
+            file.write("\0\0\0\0\0\0\0\0", 8);
+        }
+        REQUIRE_THROWS_AS((FixedPointNpyFile<1,15>{ path }),
+                          std::runtime_error);
+    }
+}
@@ -0,0 +1,83 @@
+/*
+ * Built with '_DEBUG_COUNT_OPERATIONS' defined, into its own test executable,
+ * as FixedPoint.h must be compiled the same way in every translation unit.
+ */
+#include "catch.hpp"
+#include "FixedPoint.h"
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+/*
+ * Count of 'op' with operand 'formats' in the report, e.g, "<8,8>, <8,8>",
+ * and zero if the report does not list it.
+ */
+static unsigned long long reported_count(const std::string &op,
+                                         const std::string &formats)
+{
+    std::ostringstream report{};
+    fixed_point_report_op_counts(report);
+    std::istringstream lines{ report.str() };
+    for (std::string line; std::getline(lines, line); )
+    {
+        std::size_t name_end = line.find('<');
+        std::size_t count_begin = line.find_last_of(' ') + 1;
+        if (name_end == std::string::npos ||
+            line.compare(4, op.size() + 1, op + " ") != 0)
+        {
+            continue;
+        }
+        std::string fmts = line.substr(name_end, count_begin - name_end);
+        fmts.erase(fmts.find_last_not_of(' ') + 1);
+        if (fmts == formats)
+            return std::stoull(line.substr(count_begin));
+    }
+    return 0;
+}
+
+TEST_CASE("Operations are counted per operation and operand formats.")
+{
+    REQUIRE(reported_count("mul_scenario1", "<8,8>, <8,8>") == 0);
+
+    FixedPoint<8,8> a{ 1.5 }, b{ -2.25 };
+    FixedPoint<25,21> c{ 3.0 }, d{ 0.5 };
+    REQUIRE(reported_count("from_double", "<8,8>") == 2);
+    REQUIRE(reported_count("from_double", "<25,21>") == 2);
+
+    /*
+     * Products that fit in 64 bits take scenario 1, others scenario 2, and
+     * neither is rounded.
+     */
+    FixedPoint<16,16> p{ a * b };
+    REQUIRE(reported_count("mul_scenario1", "<8,8>, <8,8>") == 1);
+    REQUIRE(reported_count("mul_scenario2", "<8,8>, <8,8>") == 0);
+    FixedPoint<32,32> q{ c * d };
+    REQUIRE(reported_count("mul_scenario2", "<25,21>, <25,21>") == 1);
+    REQUIRE(reported_count("mul_scenario1", "<25,21>, <25,21>") == 0);
+
+    /*
+     * Short expression. The sum is exact and not rounded, the difference
+     * with the Q(16,16) product and the conversion to Q(10,6) are.
+     */
+    unsigned long long rounds = reported_count("round", "<8,8>");
+    FixedPoint<10,6> e{ a + b - p };
+    REQUIRE(reported_count("add", "<8,8>, <8,8>") == 1);
+    REQUIRE(reported_count("sub", "<8,8>, <16,16>") == 1);
+    REQUIRE(reported_count("round", "<8,8>") == rounds + 1);
+    REQUIRE(reported_count("from_fixed_point", "<10,6>, <8,8>") == 1);
+    REQUIRE(reported_count("round", "<10,6>") == 1);
+
+    /*
+     * Counts of threads that have exited are included.
+     */
+    std::thread thread{ [&a, &b]
+    {
+        for (int i=0; i<10; ++i)
+            a += b;
+    } };
+    thread.join();
+    REQUIRE(reported_count("add", "<8,8>, <8,8>") == 11);
+    static_cast<void>(q);
+    static_cast<void>(e);
+}
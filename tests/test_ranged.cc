@@ -0,0 +1,91 @@
+#include "catch.hpp"
+#include "FixedPointRanged.h"
+#include <algorithm>
+#include <climits>
+
+
+TEST_CASE("Intervals propagate through expressions.")
+{
+    FixedPoint<1,15> sample{ -0.75 };
+    FixedPoint<1,15> coeff{ 0.3 };
+    auto x = make_ranged_fixed_point(sample);
+    auto c = assume_fixed_point_range<9830, 9830>(coeff);
+    REQUIRE(coeff.get_raw() == 9830);
+    REQUIRE(x.lower_raw() == -32768);
+    REQUIRE(x.upper_raw() == 32767);
+
+    /*
+     * The product of a constant in [0, 0.3] fits in Q(0,30), while an
+     * ExactFixedPoint product would need Q(2,30).
+     */
+    auto p = x * c;
+    REQUIRE(p.get_int_bits() == 0);
+    REQUIRE(p.get_frac_bits() == 30);
+    REQUIRE(p.lower_raw() == -32768ll * 9830);
+    REQUIRE(p.upper_raw() == 32767ll * 9830);
+
+    auto y = x * c + x;
+    REQUIRE(y.get_int_bits() == 2);
+    REQUIRE(y.lower() == Approx(-1.3).epsilon(1e-4));
+    REQUIRE(static_cast<double>(y) ==
+            static_cast<double>(sample) * static_cast<double>(coeff) +
+            static_cast<double>(sample));
+    REQUIRE(static_cast<double>(y.value()) == static_cast<double>(y));
+
+    auto z = -x - p;
+    REQUIRE(z.lower_raw() == -32767ll * 32768 - 32767ll * 9830);
+    REQUIRE(z.upper_raw() ==  32768ll * 32768 + 32768ll * 9830);
+    REQUIRE(static_cast<double>(z) == -static_cast<double>(y));
+
+    /*
+     * The full range of Q(32,32) numbers.
+     */
+    auto wide = make_ranged_fixed_point(FixedPoint<32,32>{ -2.5 });
+    REQUIRE(wide.lower_raw() == LLONG_MIN);
+    REQUIRE(wide.upper_raw() == LLONG_MAX);
+    REQUIRE(static_cast<double>(wide) == -2.5);
+}
+
+TEST_CASE("Saturation is elided where it is provably dead.")
+{
+    FixedPoint<1,15> coeff{ 0.3 };
+    auto c = assume_fixed_point_range<9830, 9830>(coeff);
+
+    FixedPoint<1,15> sample{};
+    using full = decltype(make_ranged_fixed_point(sample) * c +
+                          make_ranged_fixed_point(sample));
+    using half = decltype(assume_fixed_point_range<-16384, 16384>(sample) * c +
+                          assume_fixed_point_range<-16384, 16384>(sample));
+    REQUIRE_FALSE(full::fits_in<1,15>());
+    REQUIRE(full::fits_in<2,15>());
+    REQUIRE(half::fits_in<1,15>());
+    REQUIRE(half::fits_in<1,30>());
+    REQUIRE_FALSE(half::fits_in<0,16>());
+
+    /*
+     * Saturation equals clamping of the rounded result, for every input.
+     */
+    for (long long raw=-32768; raw<32768; ++raw)
+    {
+        sample.set_raw(raw);
+        auto x = make_ranged_fixed_point(sample);
+        auto y = x * c + x;
+        long long ref = y.round_to<4,15>().get_raw();
+        ref = std::min(std::max(ref, -32768ll), 32767ll);
+        REQUIRE(y.saturate_to<1,15>().get_raw() == ref);
+
+        long long ref_frac32 = (y - c).round_to<4,32>().get_raw();
+        ref_frac32 = std::min(std::max(ref_frac32, -(1ll << 32)),
+                              (1ll << 32) - 1);
+        REQUIRE((y - c).saturate_to<1,32>().get_raw() == ref_frac32);
+        REQUIRE(x.saturate_to<0,16>().get_raw() ==
+                std::min(std::max(2 * raw, -32768ll), 32767ll));
+
+        if (raw >= -16384 && raw <= 16384)
+        {
+            auto h = assume_fixed_point_range<-16384, 16384>(sample);
+            REQUIRE((h * c + h).saturate_to<1,15>() ==
+                    (h * c + h).round_to<1,15>());
+        }
+    }
+}
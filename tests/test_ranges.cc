@@ -0,0 +1,121 @@
+/*
+ * Built with '_DEBUG_PROFILE_RANGES' defined, into its own test executable,
+ * as FixedPoint.h must be compiled the same way in every translation unit.
+ */
+#include "catch.hpp"
+#include "FixedPoint.h"
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+/*
+ * Reported statistics of a tag and format, e.g, "adc <8,4>", or an empty
+ * string if the report does not list them.
+ */
+static std::string reported_range(const std::string &tag_and_format)
+{
+    std::ostringstream report{};
+    fixed_point_report_ranges(report);
+    std::istringstream lines{ report.str() };
+    const std::string prefix{ "    " + tag_and_format + ": " };
+    for (std::string line; std::getline(lines, line); )
+    {
+        if (line.compare(0, prefix.size(), prefix) == 0)
+            return line.substr(prefix.size());
+    }
+    return "";
+}
+
+/*
+ * Suggested format, or "no suggestion", the last item of reported_range().
+ */
+static std::string reported_suggestion(const std::string &tag_and_format)
+{
+    std::string range{ reported_range(tag_and_format) };
+    return range.substr(range.rfind(", ") + 2);
+}
+
+TEST_CASE("Ranges and suggested formats are reported per tag and format.")
+{
+    /*
+     * Exactly representable values, the suggestion is the smallest format
+     * that holds them.
+     */
+    {
+        FixedPointRangeTag tag{ "exact" };
+        for (double x : { 1.5, -3.25, 10.0625 })
+            static_cast<void>(FixedPoint<8,8>{ x });
+    }
+    REQUIRE(reported_range("exact <8,8>") ==
+            "3 values in [-3.25, 10.0625], max error 0, rms error 0, "
+            "0 overflows, suggest <5,4>");
+
+    /*
+     * Values are recorded after rounding to their own format, so results of
+     * multiplications never ask for more fractional bits than the format.
+     */
+    {
+        FixedPointRangeTag tag{ "rounded" };
+        FixedPoint<4,2> a{ 1.25 }, b{ 0.75 };
+        static_cast<void>(FixedPoint<4,2>{ a * b });
+        static_cast<void>(FixedPoint<4,2>{ a * a });
+    }
+    REQUIRE(reported_range("rounded <4,2>") ==
+            "4 values in [0.75, 1.5], max error 0.0625, "
+            "rms error 0.0441942, 0 overflows, suggest <2,2>");
+
+    /*
+     * A precision target trades fractional bits for rounding error.
+     */
+    fixed_point_set_range_precision(0.5);
+    REQUIRE(reported_suggestion("exact <8,8>") == "suggest <5,0>");
+    fixed_point_set_range_precision(0.25);
+    REQUIRE(reported_suggestion("exact <8,8>") == "suggest <5,1>");
+    fixed_point_set_range_precision(0.0);
+
+    /*
+     * Overflows are counted, and zero-only data has no suggestion.
+     */
+    {
+        FixedPointRangeTag tag{ "overflow" };
+        static_cast<void>(FixedPoint<4,0>{ 7.0 });
+        static_cast<void>(FixedPoint<4,0>{ 8.0 });
+        static_cast<void>(FixedPoint<4,0>{ -9.0 });
+    }
+    REQUIRE(reported_range("overflow <4,0>") ==
+            "3 values in [-9, 8], max error 0, rms error 0, "
+            "2 overflows, suggest <5,0>");
+    {
+        FixedPointRangeTag tag{ "zero" };
+        static_cast<void>(FixedPoint<8,8>{ 0.0 });
+    }
+    REQUIRE(reported_range("zero <8,8>") ==
+            "1 values in [0, 0], max error 0, rms error 0, "
+            "0 overflows, no suggestion");
+
+    /*
+     * Tags nest, and values recorded by threads that have exited are
+     * included.
+     */
+    {
+        FixedPointRangeTag outer{ "outer" };
+        {
+            FixedPointRangeTag inner{ "inner" };
+            static_cast<void>(FixedPoint<6,2>{ 2.0 });
+        }
+        static_cast<void>(FixedPoint<6,2>{ -1.0 });
+        std::thread thread{ []
+        {
+            FixedPointRangeTag tag{ "outer" };
+            static_cast<void>(FixedPoint<6,2>{ 3.0 });
+        } };
+        thread.join();
+    }
+    REQUIRE(reported_range("inner <6,2>") ==
+            "1 values in [2, 2], max error 0, rms error 0, "
+            "0 overflows, suggest <3,0>");
+    REQUIRE(reported_range("outer <6,2>") ==
+            "2 values in [-1, 3], max error 0, rms error 0, "
+            "0 overflows, suggest <3,0>");
+}
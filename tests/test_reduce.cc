@@ -0,0 +1,101 @@
+#include "catch.hpp"
+#include "FixedPointReduce.h"
+#include <cstdint>
+#include <random>
+#include <vector>
+
+
+TEST_CASE("Parallel reductions equal the sequential loops.")
+{
+    const std::size_t n = 100003;
+    std::mt19937 gen{ 1 };
+    std::uniform_int_distribution<std::int32_t> dist16{ -32768, 32767 };
+    std::uniform_int_distribution<std::int32_t> dist28{ -(1 << 27),
+                                                        (1 << 27) - 1 };
+    std::vector<std::int16_t> buf_a(n), buf_b(n);
+    std::vector<std::int32_t> buf_c(n);
+    for (std::size_t i=0; i<n; ++i)
+    {
+        buf_a[i] = static_cast<std::int16_t>(dist16(gen));
+        buf_b[i] = static_cast<std::int16_t>(dist16(gen));
+        buf_c[i] = dist28(gen);
+    }
+    FixedPointSpan<1,15,const std::int16_t> a{ buf_a.data(), n };
+    FixedPointSpan<1,15,const std::int16_t> b{ buf_b.data(), n };
+    FixedPointSpan<8,20,const std::int32_t> c{ buf_c.data(), n };
+
+    /*
+     * Sequential references.
+     */
+    FixedPoint<32,15> sum_a{};
+    FixedPoint<5,15> sum_a_wrapped{};
+    FixedPoint<32,30> dot_ab{};
+    FixedPoint<12,32> dot_cc{};
+    FixedPoint<1,15> min_a{ a.get(0) }, max_a{ a.get(0) };
+    FixedPoint<8,20> min_c{ c.get(0) }, max_c{ c.get(0) };
+    __extension__ __int128 exact_c{ 0 };
+    for (std::size_t i=0; i<n; ++i)
+    {
+        sum_a += a.get(i);
+        sum_a_wrapped += a.get(i);
+        dot_ab += a.get(i) * b.get(i);
+        dot_cc += c.get(i) * c.get(i);
+        min_a = a.get(i) < min_a ? a.get(i) : min_a;
+        max_a = a.get(i) > max_a ? a.get(i) : max_a;
+        min_c = c.get(i) < min_c ? c.get(i) : min_c;
+        max_c = c.get(i) > max_c ? c.get(i) : max_c;
+        exact_c += c.get(i).get_raw();
+    }
+    __extension__ __int128 mean_num = 2*exact_c + n;
+    __extension__ __int128 mean_raw = mean_num / (2*n) -
+        (mean_num < 0 && mean_num % (2*n) != 0);
+
+    /*
+     * Bit-identical results without a pool and for any number of threads.
+     */
+    REQUIRE(fixed_point_sum(a) == sum_a);
+    REQUIRE(fixed_point_sum<5>(a) == sum_a_wrapped);
+    REQUIRE(fixed_point_dot(a, b) == dot_ab);
+    REQUIRE(fixed_point_dot<12>(c, c) == dot_cc);
+    REQUIRE(fixed_point_min(a) == min_a);
+    REQUIRE(fixed_point_max(c) == max_c);
+    REQUIRE(fixed_point_mean(c).get_raw() == mean_raw);
+    for (unsigned threads : { 1u, 2u, 3u, 8u })
+    {
+        FixedPointThreadPool pool{ threads };
+        REQUIRE(pool.size() == threads);
+        REQUIRE(fixed_point_sum(a, pool) == sum_a);
+        REQUIRE(fixed_point_sum<5>(a, pool) == sum_a_wrapped);
+        REQUIRE(fixed_point_dot(a, b, pool) == dot_ab);
+        REQUIRE(fixed_point_dot<12>(c, c, pool) == dot_cc);
+        REQUIRE(fixed_point_min(a, pool) == min_a);
+        REQUIRE(fixed_point_max(a, pool) == max_a);
+        REQUIRE(fixed_point_min(c, pool) == min_c);
+        REQUIRE(fixed_point_max(c, pool) == max_c);
+        REQUIRE(fixed_point_mean(c, pool).get_raw() == mean_raw);
+        REQUIRE(fixed_point_mean(a, pool) ==
+                FixedPoint<1,15>{ sum_a / static_cast<int>(n) });
+    }
+}
+
+TEST_CASE("Reductions of short and empty spans.")
+{
+    std::int32_t buf[] = { 5, -3, 7, -8 };
+    FixedPointSpan<4,0,std::int32_t> x{ buf, 4 };
+    REQUIRE(fixed_point_sum(x) == FixedPoint<32,0>{ 1 });
+    REQUIRE(fixed_point_min(x) == FixedPoint<4,0>{ -8 });
+    REQUIRE(fixed_point_max(x) == FixedPoint<4,0>{ 7 });
+    REQUIRE(fixed_point_mean(x) == FixedPoint<4,0>{ 0 });
+    REQUIRE(fixed_point_mean(x.subspan(0, 3)) == FixedPoint<4,0>{ 3 });
+
+    // Storage bits above those of the format are ignored, like by get().
+    buf[0] = 5 + 16;
+    REQUIRE(fixed_point_sum(x) == FixedPoint<32,0>{ 1 });
+
+    FixedPointSpan<4,0,std::int32_t> empty{};
+    REQUIRE(fixed_point_sum(empty) == FixedPoint<32,0>{ 0 });
+    REQUIRE_THROWS_AS(fixed_point_min(empty), std::runtime_error);
+    REQUIRE_THROWS_AS(fixed_point_mean(empty), std::runtime_error);
+    REQUIRE_THROWS_AS(fixed_point_dot(x, x.subspan(0, 3)),
+                      std::runtime_error);
+}
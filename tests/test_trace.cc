@@ -0,0 +1,196 @@
+#include "catch.hpp"
+#include "FixedPointTrace.h"
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+
+TEST_CASE("Trace recording and text conversion.")
+{
+    std::stringstream trace{};
+    {
+        FixedPointTraceRecorder recorder{ trace };
+        auto x_probe = recorder.probe<4,4>("x");
+        auto y_probe = recorder.probe<10,6>("filter out");
+
+        /*
+         * More values than fit in a ring buffer, from two threads.
+         */
+        std::thread t{ [&]
+        {
+            for (unsigned long long i=0; i<40000; ++i)
+                x_probe.record(FixedPoint<4,4>{ 0.5 }, 2*i+1);
+        } };
+        for (unsigned long long i=0; i<40000; ++i)
+        {
+            FixedPointTraceRecorder::set_time(2*i);
+            y_probe.record(FixedPoint<10,6>{ -19.125 });
+        }
+        t.join();
+    }
+
+    FixedPointTrace contents = read_trace(trace);
+    REQUIRE(contents.probes.size() == 2);
+    REQUIRE(contents.probes[1].name == "filter out");
+    REQUIRE(contents.probes[1].int_bits == 10);
+    REQUIRE(contents.probes[1].frac_bits == 6);
+    REQUIRE(contents.values.size() == 80000);
+    bool in_order = true;
+    for (std::size_t i=0; i<contents.values.size(); ++i)
+    {
+        const FixedPointTrace::Value &value = contents.values[i];
+        in_order &= value.time == i;
+        in_order &= value.probe == (i % 2 ? 0u : 1u);
+        in_order &= value.raw == (i % 2 ? 8 : -1224);
+    }
+    REQUIRE(in_order);
+
+    trace.clear();
+    trace.seekg(0);
+    std::stringstream text{};
+    fixed_point_trace_to_text(trace, text);
+    std::string line{};
+    REQUIRE(std::getline(text, line));
+    REQUIRE(line == "0 filter out -19.125");
+    REQUIRE(std::getline(text, line));
+    REQUIRE(line == "1 x 0.5");
+}
+
+TEST_CASE("Half full rings are written without waiting for the interval.")
+{
+    /*
+     * Stream buffer that the test can read while the recorder writes to it.
+     * Blocks of values are written by single calls, so the copy is a valid
+     * trace.
+     */
+    struct SharedBuffer : std::streambuf
+    {
+        std::mutex mutex{};
+        std::string content{};
+
+        std::streamsize xsputn(const char *s, std::streamsize n) override
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            this->content.append(s, static_cast<std::size_t>(n));
+            return n;
+        }
+        int_type overflow(int_type c) override
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            this->content.push_back(traits_type::to_char_type(c));
+            return c;
+        }
+        std::size_t values()
+        {
+            std::lock_guard<std::mutex> lock{ this->mutex };
+            std::stringstream copy{ this->content };
+            return read_trace(copy).values.size();
+        }
+    };
+    SharedBuffer buffer{};
+    std::ostream os{ &buffer };
+
+    /*
+     * Bursts of half a ring, several times around it. With a flush interval
+     * of an hour, only the half full signal gets each burst written before
+     * the next one, and a missed signal leaves it in the ring.
+     */
+    const std::size_t burst = fixed_point_detail::TRACE_RING_VALUES / 2;
+    FixedPointTraceRecorder recorder{ os, std::chrono::hours{ 1 } };
+    auto probe = recorder.probe<8,8>("x");
+    std::size_t recorded{ 0 };
+    for (int i=0; i<8; ++i)
+    {
+        for (std::size_t j=0; j<burst; ++j)
+            probe.record(FixedPoint<8,8>{}, recorded++);
+        auto deadline = std::chrono::steady_clock::now() +
+                        std::chrono::seconds{ 10 };
+        while (buffer.values() != recorded &&
+               std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds{ 1 });
+        }
+        REQUIRE(buffer.values() == recorded);
+    }
+    REQUIRE(recorder.stalls() == 0);
+}
+
+TEST_CASE("Trace conversion to VCD.")
+{
+    std::stringstream trace{};
+    {
+        FixedPointTraceRecorder recorder{ trace };
+        auto probe = recorder.probe<2,2>("a");
+        probe.record(FixedPoint<2,2>{ 1.25 }, 0);
+        probe.record(FixedPoint<2,2>{ -0.5 }, 10);
+    }
+
+    std::stringstream vcd{};
+    fixed_point_trace_to_vcd(trace, vcd, "1ps");
+    std::string expected =
+        "$timescale 1ps $end\n"
+        "$scope module fixed_point_trace $end\n"
+        "$var wire 4 ! a $end\n"
+        "$comment a is Q(2,2) $end\n"
+        "$upscope $end\n$enddefinitions $end\n"
+        "#0\nb0101 !\n"
+        "#10\nb1110 !\n";
+    REQUIRE(vcd.str() == expected);
+
+    std::stringstream garbage{ "PMFT\1\0\0\0X" };
+    REQUIRE_THROWS_AS(read_trace(garbage), std::runtime_error);
+}
+
+TEST_CASE("Corrupt trace files throw.")
+{
+    /*
+     * Trace of one probe with format 'int_bits', 'frac_bits', followed by a
+     * value block header claiming 'count' values and a single value.
+     */
+    auto make_trace = [](int int_bits, int frac_bits, std::uint32_t count)
+    {
+        std::string file{ "PMFT\x01\0\0\0", 8 };
+        file += std::string{ "P\0\0\0\0", 5 };
+        file += static_cast<char>(int_bits);
+        file += static_cast<char>(frac_bits);
+        file += std::string{ "\x01\0" "a", 3 };
+        file += 'V';
+        for (int i=0; i<4; ++i)
+            file += static_cast<char>(count >> (8*i));
+        file += std::string(8, '\0') + std::string(4, '\0') + "\x05" +
+                std::string(7, '\0');
+        return file;
+    };
+
+    std::stringstream valid{ make_trace(2, 2, 1) };
+    REQUIRE(read_trace(valid).values.size() == 1);
+
+    /*
+     * Formats that no FixedPoint number has.
+     */
+    const int formats[][2] = {
+        { 2, -1 }, { 2, 33 }, { 0, 0 }, { -20, 4 }, { 40, 30 }, { 127, 127 }
+    };
+    for (const int *format : formats)
+    {
+        std::stringstream corrupt{ make_trace(format[0], format[1], 1) };
+        REQUIRE_THROWS_AS(read_trace(corrupt), std::runtime_error);
+    }
+
+    /*
+     * More values than the file holds, up to the largest count.
+     */
+    for (std::uint32_t count : { 2u, 100000u, 0xFFFFFFFFu })
+    {
+        std::stringstream truncated{ make_trace(2, 2, count) };
+        REQUIRE_THROWS_AS(read_trace(truncated), std::runtime_error);
+        std::stringstream to_text{ make_trace(2, 2, count) }, text{};
+        REQUIRE_THROWS_AS(fixed_point_trace_to_text(to_text, text),
+                          std::runtime_error);
+    }
+}
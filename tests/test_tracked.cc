@@ -0,0 +1,88 @@
+#include "catch.hpp"
+#include "FixedPointTracked.h"
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+TEST_CASE("Tracked numbers carry their ideal value.")
+{
+    TrackedFixedPoint<4,4> a{ 1.3 }, b{ 0.7 };
+    REQUIRE(a.ideal() == 1.3);
+    REQUIRE(static_cast<double>(a) == 1.3125);
+    REQUIRE(a.error() == Approx(0.0125));
+
+    /*
+     * Result formats follow those of FixedPoint numbers.
+     */
+    auto prod = a * b;
+    REQUIRE(prod.get_int_bits() == 8);
+    REQUIRE(prod.get_frac_bits() == 8);
+    REQUIRE(prod.ideal() == Approx(1.3 * 0.7));
+    REQUIRE(static_cast<double>(prod) == static_cast<double>(
+            FixedPoint<4,4>{ 1.3 } * FixedPoint<4,4>{ 0.7 }));
+
+    auto sum = a + b - a / b;
+    REQUIRE(sum.ideal() == Approx(1.3 + 0.7 - 1.3 / 0.7));
+    REQUIRE((-sum).ideal() == -sum.ideal());
+
+    /*
+     * Conversion keeps the ideal value while the FixedPoint value is rounded.
+     */
+    TrackedFixedPoint<4,1> narrow{ prod };
+    REQUIRE(narrow.ideal() == prod.ideal());
+    REQUIRE(static_cast<double>(narrow) == 1.0);
+
+    TrackedFixedPoint<8,8> acc{ 0 };
+    for (int i=0; i<10; ++i)
+        acc += b;
+    REQUIRE(acc.ideal() == Approx(7.0));
+    REQUIRE(static_cast<double>(acc) == 6.875);
+
+    /*
+     * Plain FixedPoint numbers are exact.
+     */
+    TrackedFixedPoint<4,4> c{ FixedPoint<4,4>{ 1.3 } };
+    REQUIRE(c.error() == 0.0);
+    REQUIRE(c == a);
+    REQUIRE(b < a);
+}
+
+TEST_CASE("Quantization error statistics.")
+{
+    fixed_point_clear_errors();
+
+    /*
+     * Quantize a sine with Q(1,7) from several threads.
+     */
+    auto worker = [](int first)
+    {
+        for (int i=first; i<first+1000; ++i)
+        {
+            TrackedFixedPoint<1,7> x{ 0.9 * std::sin(0.01 * i) };
+            x.record("sine");
+        }
+    };
+    std::thread t{ worker, 1000 };
+    worker(0);
+    t.join();
+
+    FixedPointErrorStats stats = fixed_point_error_stats("sine");
+    REQUIRE(stats.count() == 2000);
+    REQUIRE(stats.max_abs_error() <= 1.0 / 256.0);
+    REQUIRE(std::abs(stats.bias()) < 1.0 / 1024.0);
+
+    // Uniform quantization noise, 6.02 dB per bit.
+    REQUIRE(stats.rms_error() == Approx(1.0/128.0 / std::sqrt(12.0))
+                                 .epsilon(0.1));
+    REQUIRE(stats.sqnr_db() > 40.0);
+    REQUIRE(stats.sqnr_db() < 50.0);
+
+    std::stringstream report{};
+    fixed_point_report_errors(report);
+    REQUIRE(report.str().find("sine: 2000 samples") == 0);
+
+    fixed_point_clear_errors();
+    REQUIRE(fixed_point_error_stats("sine").count() == 0);
+}
@@ -0,0 +1,67 @@
+/*
+ * Convert PoorMansFixedPoint trace files, written by FixedPointTraceRecorder,
+ * to text or to a Value Change Dump (VCD).
+ *
+ * Usage: trace_convert [--text | --vcd] [--timescale <unit>] <trace> [<out>]
+ *
+ * Output goes to standard output if no output file is given.
+ */
+
+#include "FixedPointTrace.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+int main(int argc, char **argv)
+{
+    bool vcd = false;
+    std::string timescale{ "1ns" };
+    std::string paths[2]{};
+    int n_paths = 0;
+    for (int i=1; i<argc; ++i)
+    {
+        std::string arg{ argv[i] };
+        if (arg == "--text")
+            vcd = false;
+        else if (arg == "--vcd")
+            vcd = true;
+        else if (arg == "--timescale" && i+1 < argc)
+            timescale = argv[++i];
+        else if ((arg.size() > 1 && arg[0] == '-') || n_paths == 2)
+            n_paths = 3;
+        else
+            paths[n_paths++] = arg;
+    }
+    if (n_paths < 1 || n_paths > 2)
+    {
+        std::cerr << "Usage: " << argv[0] << " [--text | --vcd] "
+                  << "[--timescale <unit>] <trace> [<out>]" << std::endl;
+        return 2;
+    }
+
+    try
+    {
+        std::ifstream in{ paths[0], std::ios::binary };
+        if (!in)
+            throw std::runtime_error("cannot open " + paths[0]);
+        std::ofstream file{};
+        if (n_paths == 2)
+        {
+            file.open(paths[1]);
+            if (!file)
+                throw std::runtime_error("cannot open " + paths[1]);
+        }
+        std::ostream &out = n_paths == 2 ? file : std::cout;
+        if (vcd)
+            fixed_point_trace_to_vcd(in, out, timescale);
+        else
+            fixed_point_trace_to_text(in, out);
+    }
+    catch (const std::exception &e)
+    {
+        std::cerr << argv[0] << ": " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}